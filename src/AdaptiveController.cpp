@@ -0,0 +1,38 @@
+#include "AdaptiveController.h"
+#include <algorithm>
+
+namespace pending_tick_optimizer {
+
+// 平滑系数，约等于最近 10 个 tick 的均值
+static constexpr double kSmoothing = 0.1;
+
+void AdaptiveController::reset(int initialBudget) {
+    mState        = {};
+    mState.budget = initialBudget;
+}
+
+int AdaptiveController::update(double mspt, Settings const& settings) {
+    mState.lastMspt   = mspt;
+    mState.smoothMspt = mState.smoothMspt <= 0.0 ? mspt : mState.smoothMspt + (mspt - mState.smoothMspt) * kSmoothing;
+    if (mState.cooldown > 0) --mState.cooldown;
+
+    double budget = mState.budget;
+    if (mspt > settings.targetMspt) {
+        // 超时按单次采样立即响应，不等平滑值
+        if (mState.cooldown == 0) {
+            budget          *= std::clamp(settings.decreaseFactor, 0.0, 1.0);
+            mState.cooldown  = std::max(0, settings.cooldownTicks);
+            ++mState.decreases;
+        }
+    } else if (mState.smoothMspt < settings.targetMspt * settings.headroom) {
+        budget += settings.increaseStep;
+        ++mState.increases;
+    }
+
+    int lo        = std::max(1, settings.minBudget);
+    int hi        = std::max(lo, settings.maxBudget);
+    mState.budget = std::clamp(static_cast<int>(budget), lo, hi);
+    return mState.budget;
+}
+
+} // namespace pending_tick_optimizer
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+
+namespace pending_tick_optimizer {
+
+// AIMD 预算控制器：MSPT 有余量时线性加预算，超出目标时按比例砍预算
+// 只在服务器线程上调用
+class AdaptiveController {
+public:
+    struct Settings {
+        double targetMspt     = 45.0;
+        double headroom       = 0.8; // 平滑 MSPT 低于 target * headroom 才加预算
+        double decreaseFactor = 0.5;
+        int    increaseStep   = 10;
+        int    minBudget      = 50;
+        int    maxBudget      = 2000;
+        int    cooldownTicks  = 5; // 两次削减之间至少间隔的 tick 数，避免一次长卡顿连砍到底
+    };
+
+    struct State {
+        int      budget     = 0;
+        double   lastMspt   = 0.0;
+        double   smoothMspt = 0.0;
+        uint64_t increases  = 0;
+        uint64_t decreases  = 0;
+        int      cooldown   = 0;
+    };
+
+    void reset(int initialBudget);
+
+    // 每 tick 结束时喂入本 tick 耗时，返回下一 tick 使用的预算
+    int update(double mspt, Settings const& settings);
+
+    [[nodiscard]] int          budget() const noexcept { return mState.budget; }
+    [[nodiscard]] State const& state() const noexcept { return mState; }
+    void                       restore(State const& state) { mState = state; }
+
+private:
+    State mState;
+};
+
+} // namespace pending_tick_optimizer
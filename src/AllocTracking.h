@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+
+namespace pending_tick_optimizer {
+
+// 调试构建（PTO_ALLOC_TRACKING）下，MemoryOperators.cpp 里的 operator new 按线程统计本模块的堆分配次数，
+// 用来确认稳态 tick 的热路径不分配；发布构建里恒为 0，调用点不需要条件编译
+#ifdef PTO_ALLOC_TRACKING
+inline constexpr bool kAllocTracking = true;
+[[nodiscard]] uint64_t threadAllocations() noexcept;
+#else
+inline constexpr bool kAllocTracking = false;
+[[nodiscard]] inline uint64_t threadAllocations() noexcept { return 0; }
+#endif
+
+} // namespace pending_tick_optimizer
@@ -0,0 +1,351 @@
+#include "Benchmark.h"
+#include "PendingTickOptimizer.h"
+#include "ll/api/chrono/GameChrono.h"
+#include "ll/api/coro/CoroTask.h"
+#include "ll/api/thread/ServerThreadExecutor.h"
+#include "mc/world/actor/Actor.h"
+#include "mc/world/level/BlockPos.h"
+#include "mc/world/level/BlockSource.h"
+#include "mc/world/level/block/Block.h"
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace pending_tick_optimizer {
+
+static constexpr int kCellSize    = 6; // 每个结构占一个 6x6 的格子，彼此不会互相触发
+static constexpr int kRowLength   = 8;
+static constexpr int kBlockUpdate = 3; // 通知邻居并同步给客户端
+
+// 搭建过的位置和原来的方块，拆除时倒序恢复
+struct PlacedBlock {
+    BlockPos     pos;
+    Block const* original;
+};
+
+static bool                     running   = false;
+static uint32_t                 runId     = 0;
+static int                      dimension = 0;
+static std::vector<PlacedBlock> placed;
+
+bool benchmarkRunning() { return running; }
+
+void stopBenchmark() {
+    // 进行中的协程醒来后发现 runId 变了就直接退出，不写报告
+    running = false;
+    ++runId;
+}
+
+// ── 场景搭建 ──────────────────────────────────────────────
+
+// 场景只占用整片空气的区域，搭建前先检查，拆除时逐格恢复原样，不会覆盖或残留玩家的方块
+struct Layout {
+    std::vector<std::pair<BlockPos, Block const*>> blocks;   // 按搭建顺序
+    std::vector<BlockPos>                          reserved; // 不放方块但流体会流进去的格子
+};
+
+static bool planLayout(BlockPos base, BenchmarkScenario const& scenario, Layout& layout) {
+    // 朝向用旧数据值表示：传送门 1 为沿 X 轴，侦测器 0 朝下、1 朝上
+    auto obsidian     = Block::tryGetFromRegistry("minecraft:obsidian");
+    auto portal       = Block::tryGetFromRegistry("minecraft:portal", 1);
+    auto observerUp   = Block::tryGetFromRegistry("minecraft:observer", 1);
+    auto observerDown = Block::tryGetFromRegistry("minecraft:observer", 0);
+    auto stone        = Block::tryGetFromRegistry("minecraft:stone");
+    auto water        = Block::tryGetFromRegistry("minecraft:water");
+    if (!obsidian || !portal || !observerUp || !observerDown || !stone || !water) return false;
+
+    int  cell = 0;
+    auto next = [&]() {
+        BlockPos origin{base.x + (cell % kRowLength) * kCellSize, base.y, base.z + (cell / kRowLength) * kCellSize};
+        ++cell;
+        return origin;
+    };
+    auto place = [&](BlockPos const& pos, Block const& block) { layout.blocks.emplace_back(pos, &block); };
+
+    for (int i = 0; i < scenario.portals; ++i) {
+        auto origin = next();
+        // 先放 4x5 的黑曜石框，再填 2x3 的传送门，顺序反了传送门会立即失效
+        for (int dx = 0; dx < 4; ++dx) {
+            for (int dy = 0; dy < 5; ++dy) {
+                bool inside = dx > 0 && dx < 3 && dy > 0 && dy < 4;
+                if (!inside) place({origin.x + dx, origin.y + dy, origin.z}, *obsidian);
+            }
+        }
+        for (int dx = 1; dx < 3; ++dx) {
+            for (int dy = 1; dy < 4; ++dy) place({origin.x + dx, origin.y + dy, origin.z}, *portal);
+        }
+    }
+    for (int i = 0; i < scenario.clocks; ++i) {
+        auto origin = next();
+        // 上面的侦测器放下时触发下面的，之后两者互相触发，每两 tick 一个计划刻
+        place(origin, *observerUp);
+        place({origin.x, origin.y + 1, origin.z}, *observerDown);
+    }
+    for (int i = 0; i < scenario.fluids; ++i) {
+        auto origin = next();
+        // 5x5 的石底加一圈石墙围成水池，水源放在中央，只能流进池内的 3x3，不会漫出格子
+        for (int dx = 0; dx < 5; ++dx) {
+            for (int dz = 0; dz < 5; ++dz) {
+                place({origin.x + dx, origin.y, origin.z + dz}, *stone);
+                bool wall = dx == 0 || dx == 4 || dz == 0 || dz == 4;
+                if (wall) {
+                    place({origin.x + dx, origin.y + 1, origin.z + dz}, *stone);
+                } else if (dx != 2 || dz != 2) {
+                    layout.reserved.push_back({origin.x + dx, origin.y + 1, origin.z + dz});
+                }
+            }
+        }
+        place({origin.x + 2, origin.y + 1, origin.z + 2}, *water);
+    }
+    return true;
+}
+
+static bool build(BlockSource& region, BlockPos base, BenchmarkScenario const& scenario) {
+    auto   air = Block::tryGetFromRegistry("minecraft:air");
+    Layout layout;
+    if (!air || !planLayout(base, scenario, layout)) return false;
+
+    // 目标区域里只要有一格不是空气就拒绝搭建
+    auto empty = [&](BlockPos const& pos) { return &region.getBlock(pos) == &*air; };
+    for (auto const& [pos, block] : layout.blocks) {
+        if (!empty(pos)) {
+            logger().warn("Benchmark area is not empty at ({}, {}, {}), refusing to build", pos.x, pos.y, pos.z);
+            return false;
+        }
+    }
+    for (auto const& pos : layout.reserved) {
+        if (!empty(pos)) {
+            logger().warn("Benchmark area is not empty at ({}, {}, {}), refusing to build", pos.x, pos.y, pos.z);
+            return false;
+        }
+    }
+
+    // 池内的格子先登记，倒序拆除时最后处理，流动的水在水源拆掉之后再清
+    for (auto const& pos : layout.reserved) placed.push_back({pos, &region.getBlock(pos)});
+    for (auto const& [pos, block] : layout.blocks) {
+        Block const* original = &region.getBlock(pos);
+        if (!region.setBlock(pos, *block, kBlockUpdate, nullptr, nullptr)) {
+            // 通常是区块没加载：已经放下的全部恢复
+            logger().warn("Failed to place benchmark block at ({}, {}, {})", pos.x, pos.y, pos.z);
+            for (auto it = placed.rbegin(); it != placed.rend(); ++it) {
+                region.setBlock(it->pos, *it->original, kBlockUpdate, nullptr, nullptr);
+            }
+            placed.clear();
+            return false;
+        }
+        placed.push_back({pos, original});
+    }
+    return true;
+}
+
+size_t clearBenchmark(Actor& actor) {
+    if (placed.empty() || actor.getDimensionId().id != dimension) return 0;
+    auto&  region   = actor.getDimensionBlockSource();
+    size_t restored = 0;
+    for (auto it = placed.rbegin(); it != placed.rend(); ++it) {
+        if (region.setBlock(it->pos, *it->original, kBlockUpdate, nullptr, nullptr)) ++restored;
+    }
+    placed.clear();
+    return restored;
+}
+
+// ── 报告 ──────────────────────────────────────────────────
+
+static nlohmann::json toJson(LatencyHistogram::Summary const& summary) {
+    return {
+        {"count", summary.count},
+        {"mean",  summary.mean },
+        {"p50",   summary.p50  },
+        {"p99",   summary.p99  },
+        {"p999",  summary.p999 },
+        {"max",   summary.max  },
+    };
+}
+
+static nlohmann::json scenarioJson(BenchmarkScenario const& scenario) {
+    return {
+        {"ticks",       scenario.ticks      },
+        {"warmupTicks", scenario.warmupTicks},
+        {"portals",     scenario.portals    },
+        {"clocks",      scenario.clocks     },
+        {"fluids",      scenario.fluids     },
+    };
+}
+
+static nlohmann::json buildReport(BenchmarkScenario const& scenario, uint32_t ticks, StatsSample const& sample) {
+    auto const& cfg = currentConfig();
+
+    uint64_t calls     = 0;
+    uint64_t capped    = 0;
+    uint64_t processed = 0;
+    auto     policies  = nlohmann::json::array();
+    for (auto const& policy : sample.policies) {
+        calls     += policy.calls;
+        capped    += policy.capped;
+        processed += policy.processed;
+        double capRate = policy.calls > 0 ? static_cast<double>(policy.capped) / static_cast<double>(policy.calls) : 0.0;
+        policies.push_back({
+            {"name",      policy.name     },
+            {"calls",     policy.calls    },
+            {"capped",    policy.capped   },
+            {"processed", policy.processed},
+            {"capRate",   capRate         },
+        });
+    }
+
+    nlohmann::json report;
+    report["version"]       = 1;
+    report["timestamp"]     = sample.timestampMs;
+    report["scenario"]      = scenarioJson(scenario);
+    report["measuredTicks"] = ticks;
+    report["config"]        = {
+        {"budgetEnabled",       cfg.budgetEnabled      },
+        {"budgetMode",          cfg.budgetMode         },
+        {"budgetPerTick",       cfg.budgetPerTick      },
+        {"globalBudgetPerTick", cfg.globalBudgetPerTick},
+        {"adaptiveBudget",      cfg.adaptiveBudget     },
+        {"costModelEnabled",    cfg.costModelEnabled   },
+        {"proximityPriority",   cfg.proximityPriority  },
+        {"coalesceEnabled",     cfg.coalesceEnabled    },
+        {"compactionEnabled",   cfg.compactionEnabled  },
+    };
+    report["msptMs"]           = toJson(sample.tickMs);
+    report["policies"]         = std::move(policies);
+    report["capRate"]          = calls > 0 ? static_cast<double>(capped) / static_cast<double>(calls) : 0.0;
+    report["processedPerTick"] = ticks > 0 ? static_cast<double>(processed) / ticks : 0.0;
+    if (sample.latencyTiming) {
+        report["pendingTicksUs"] = {
+            {"throttled",   toJson(sample.throttledUs)  },
+            {"passThrough", toJson(sample.passThroughUs)},
+        };
+    }
+    return report;
+}
+
+static double numberAt(nlohmann::json const& json, char const* key, char const* field = nullptr) {
+    auto it = json.find(key);
+    if (it == json.end()) return 0.0;
+    if (field) {
+        if (!it->is_object()) return 0.0;
+        auto inner = it->find(field);
+        return inner != it->end() && inner->is_number() ? inner->get<double>() : 0.0;
+    }
+    return it->is_number() ? it->get<double>() : 0.0;
+}
+
+// 与上一次同场景的报告对比，场景不同时没有可比性
+static void logComparison(nlohmann::json const& previous, nlohmann::json const& current) {
+    if (!previous.is_object() || previous.value("scenario", nlohmann::json{}) != current["scenario"]) return;
+    auto delta = [](double before, double after) {
+        return before != 0.0 ? fmt::format("{:+.1f}%", (after - before) / before * 100.0) : std::string("n/a");
+    };
+    double meanBefore = numberAt(previous, "msptMs", "mean");
+    double meanAfter  = numberAt(current, "msptMs", "mean");
+    double p99Before  = numberAt(previous, "msptMs", "p99");
+    double p99After   = numberAt(current, "msptMs", "p99");
+    double capBefore  = numberAt(previous, "capRate");
+    double capAfter   = numberAt(current, "capRate");
+    double rateBefore = numberAt(previous, "processedPerTick");
+    double rateAfter  = numberAt(current, "processedPerTick");
+    logger().info(
+        "Benchmark vs previous | mspt mean: {:.2f} -> {:.2f} ({}) | p99: {:.2f} -> {:.2f} ({}) | cap rate: {:.1f}% -> "
+        "{:.1f}% | processed/tick: {:.1f} -> {:.1f} ({})",
+        meanBefore,
+        meanAfter,
+        delta(meanBefore, meanAfter),
+        p99Before,
+        p99After,
+        delta(p99Before, p99After),
+        capBefore * 100.0,
+        capAfter * 100.0,
+        rateBefore,
+        rateAfter,
+        delta(rateBefore, rateAfter)
+    );
+}
+
+static void writeReport(BenchmarkScenario const& scenario, uint32_t ticks, StatsSample const& sample) {
+    auto report = buildReport(scenario, ticks, sample);
+    logger().info(
+        "Benchmark | ticks: {} | mspt mean: {:.2f} | p50: {:.2f} | p99: {:.2f} | max: {:.2f} | cap rate: {:.1f}% | "
+        "processed/tick: {:.1f}",
+        ticks,
+        sample.tickMs.mean,
+        sample.tickMs.p50,
+        sample.tickMs.p99,
+        sample.tickMs.max,
+        report["capRate"].get<double>() * 100.0,
+        report["processedPerTick"].get<double>()
+    );
+
+    auto            dir = PluginImpl::getInstance().getSelf().getDataDir() / "benchmarks";
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+
+    auto latestPath = dir / "latest.json";
+    {
+        std::ifstream latest(latestPath);
+        if (latest) logComparison(nlohmann::json::parse(latest, nullptr, false), report);
+    }
+
+    auto path = dir / fmt::format("bench-{}.json", sample.timestampMs);
+    for (auto const& target : {path, latestPath}) {
+        std::ofstream file(target);
+        file << report.dump(4);
+        if (!file) {
+            logger().warn("Failed to write benchmark report {}", target.string());
+            return;
+        }
+    }
+    logger().info("Benchmark report written to {}", path.string());
+}
+
+// ── 运行 ──────────────────────────────────────────────────
+
+bool startBenchmark(Actor& actor, BenchmarkScenario const& input) {
+    BenchmarkScenario scenario{
+        .ticks       = std::max(20, input.ticks),
+        .portals     = std::clamp(input.portals, 0, 256),
+        .clocks      = std::clamp(input.clocks, 0, 256),
+        .fluids      = std::clamp(input.fluids, 0, 256),
+        .warmupTicks = std::max(0, input.warmupTicks),
+    };
+
+    // 同一位置重复运行：先拆掉上一次的场景，保证起点一致
+    clearBenchmark(actor);
+    // 搭在执行者上方接近高度上限的空中，远离地面建筑；最高的结构（传送门框）5 格
+    auto& region = actor.getDimensionBlockSource();
+    auto  feet   = actor.getFeetBlockPos();
+    dimension    = actor.getDimensionId().id;
+    if (!build(region, {feet.x + 4, region.getMaxHeight() - 8, feet.z + 4}, scenario)) return false;
+
+    running     = true;
+    uint32_t id = ++runId;
+    logger().info(
+        "Benchmark started | portals: {} | clocks: {} | fluids: {} | warmup: {} ticks | window: {} ticks",
+        scenario.portals,
+        scenario.clocks,
+        scenario.fluids,
+        scenario.warmupTicks,
+        scenario.ticks
+    );
+
+    // 测量期间统计协程暂停采集，窗口内的计数只归这一次测量
+    ll::coro::keepThis([scenario, id]() -> ll::coro::CoroTask<> {
+        co_await ll::chrono::ticks(scenario.warmupTicks);
+        if (!running || runId != id) co_return;
+        uint32_t begin = collectStats(true).serverTick;
+
+        co_await ll::chrono::ticks(scenario.ticks);
+        if (!running || runId != id) co_return;
+        auto sample = collectStats(true);
+        running     = false;
+        writeReport(scenario, sample.serverTick - begin, sample);
+    }).launch(ll::thread::ServerThreadExecutor::getDefault());
+    return true;
+}
+
+} // namespace pending_tick_optimizer
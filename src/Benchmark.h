@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+
+class Actor;
+
+namespace pending_tick_optimizer {
+
+// 合成压测场景。在执行者上方的高空按固定布局搭建传送门、侦测器时钟和围在水池里的流体源，
+// 预热后测量固定 tick 数，把 MSPT、tickPendingTicks 耗时和限流率写成报告。
+// 布局只取决于参数，同一处重复运行可以直接对比两次配置的差异。
+// 字段名即 /pto bench 的参数名。
+struct BenchmarkScenario {
+    int ticks       = 600; // 测量窗口
+    int portals     = 16;  // 2x3 的下界传送门
+    int clocks      = 32;  // 两个相对的侦测器组成的时钟
+    int fluids      = 32;  // 石墙围住的水池中央的水源
+    int warmupTicks = 100; // 搭建后先跑这么多 tick 再开始计数
+};
+
+// 方块查找失败、目标区域不全是空气或区块未加载时返回 false；调用方需先确认没有正在进行的测量
+bool startBenchmark(Actor& actor, BenchmarkScenario const& scenario);
+void stopBenchmark();
+bool benchmarkRunning();
+
+// 拆除上一次搭建的场景，逐格恢复搭建前的方块，执行者需在同一维度；返回恢复的方块数
+size_t clearBenchmark(Actor& actor);
+
+} // namespace pending_tick_optimizer
@@ -0,0 +1,28 @@
+#include "BlockClassifier.h"
+#include <algorithm>
+
+namespace pending_tick_optimizer {
+
+void BlockClassifier::setPolicies(std::vector<std::vector<std::string>> const& policyBlocks) {
+    mPolicyBlocks = policyBlocks;
+    if (mPolicyBlocks.size() > kMaxPolicies) mPolicyBlocks.resize(kMaxPolicies);
+    clear();
+}
+
+void BlockClassifier::clear() {
+    mCache.clear();
+    mLastBlock = nullptr;
+    mLastMask  = 0;
+}
+
+uint32_t BlockClassifier::resolve(void const* block, std::string_view typeName) {
+    uint32_t mask = 0;
+    for (size_t i = 0; i < mPolicyBlocks.size(); ++i) {
+        auto const& types = mPolicyBlocks[i];
+        if (std::find(types.begin(), types.end(), typeName) != types.end()) mask |= 1u << i;
+    }
+    mCache[block] = mask;
+    return mask;
+}
+
+} // namespace pending_tick_optimizer
@@ -0,0 +1,48 @@
+#pragma once
+#include "FlatMap.h"
+#include "Policy.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pending_tick_optimizer {
+
+// 方块分类缓存：每个 Block 只在第一次遇到时解析类型名，之后按指针查表
+// 结果是策略掩码，第 i 位表示该方块属于第 i 个策略的方块集合
+// Block 对象由方块调色板持有，服务器运行期间地址稳定，可以直接当键
+class BlockClassifier {
+public:
+    // 每个元素是一个策略的方块类型名列表，超出 kMaxPolicies 的部分被忽略
+    void setPolicies(std::vector<std::vector<std::string>> const& policyBlocks);
+    void clear();
+
+    // typeNameOf 只在缓存未命中时调用
+    template <class NameFn>
+    uint32_t classify(void const* block, NameFn&& typeNameOf) {
+        // 同一队列里的方块通常是同一种，先比较上一次的结果
+        if (block == mLastBlock) return mLastMask;
+        uint32_t mask;
+        if (auto* cached = mCache.find(block)) {
+            mask = *cached;
+        } else {
+            mask = resolve(block, typeNameOf());
+        }
+        mLastBlock = block;
+        mLastMask  = mask;
+        return mask;
+    }
+
+    [[nodiscard]] size_t cachedCount() const noexcept { return mCache.size(); }
+    [[nodiscard]] size_t memoryUsage() const noexcept { return mCache.memoryUsage(); }
+
+private:
+    uint32_t resolve(void const* block, std::string_view typeName);
+
+    std::vector<std::vector<std::string>> mPolicyBlocks;
+    FlatMap<void const*, uint32_t>        mCache;
+    void const*                           mLastBlock = nullptr;
+    uint32_t                              mLastMask  = 0;
+};
+
+} // namespace pending_tick_optimizer
@@ -0,0 +1,136 @@
+#include "BudgetPools.h"
+#include <algorithm>
+#include <climits>
+#include <utility>
+
+namespace pending_tick_optimizer {
+
+// 区域表里超过这么多 tick 没被访问的条目在 sweep 时清掉
+static constexpr uint32_t kAreaIdleTicks = 1200;
+
+void BudgetPools::beginTick(Limits const& limits) {
+    mLimits = limits;
+    ++mStamp;
+    int dimensionLimit = limits.dimension > 0 ? limits.dimension : INT_MAX;
+    mDimensionLeft.fill(dimensionLimit);
+    mSpare    = 0;
+    mLastSlot = -1;
+    mVisited  = 0;
+    mClosed   = 0;
+}
+
+void BudgetPools::sweep() {
+    uint32_t now = mStamp;
+    for (auto& areas : mAreas) {
+        areas.eraseIf([now](uint64_t, AreaPool const& pool) { return now - pool.stamp > kAreaIdleTicks; });
+        areas.shrinkToFit();
+    }
+}
+
+int BudgetPools::slotOf(int dimension) const noexcept {
+    // 自定义维度 id 可能超出范围，折叠进最后一个槽
+    return dimension >= 0 && dimension < kMaxDimensions ? dimension : kMaxDimensions - 1;
+}
+
+uint64_t BudgetPools::areaKey(int chunkX, int chunkZ) const noexcept {
+    auto ax = static_cast<uint32_t>(chunkX >> mLimits.areaShift);
+    auto az = static_cast<uint32_t>(chunkZ >> mLimits.areaShift);
+    // 最高位置 1，避免与空槽标记 0 冲突
+    return (1ULL << 63) | (static_cast<uint64_t>(ax & 0x7fffffffu) << 32) | az;
+}
+
+BudgetPools::AreaPool* BudgetPools::areaFor(int slot, int chunkX, int chunkZ) {
+    if (mLimits.area <= 0) return nullptr;
+    auto& pool = mAreas[slot][areaKey(chunkX, chunkZ)];
+    if (pool.stamp != mStamp) {
+        pool.stamp = mStamp;
+        pool.left  = mLimits.area;
+    }
+    return &pool;
+}
+
+void BudgetPools::closeDimension(int slot) {
+    if (mLimits.dimension <= 0 || (mClosed >> slot) & 1u) return;
+    mClosed |= 1u << slot;
+    int left = std::exchange(mDimensionLeft[slot], 0);
+    if (left > 0) mSpare += left;
+}
+
+int BudgetPools::acquire(int dimension, int chunkX, int chunkZ, int want) {
+    if (want <= 0) return 0;
+    int slot = slotOf(dimension);
+    // 维度依次 tick，切换维度说明离开过的维度本 tick 都已结束，不依赖 id 顺序；
+    // 没有调用过 acquire 的空闲维度按 id 顺序关闭，否则它的额度永远让不出来
+    if (mLimits.rollover && mLastSlot != slot) {
+        for (int other = 0; other < kMaxDimensions; ++other) {
+            if (other != slot && ((mVisited >> other) & 1u || other < slot)) closeDimension(other);
+        }
+        mVisited  |= 1u << slot;
+        mLastSlot  = slot;
+    }
+
+    auto* area = areaFor(slot, chunkX, chunkZ);
+    if (area) {
+        if (area->left <= 0) {
+            ++mCounters.areaCapped;
+            return 0;
+        }
+        want = std::min(want, area->left);
+    }
+
+    auto& dimensionLeft  = mDimensionLeft[slot];
+    int   granted        = std::clamp(dimensionLeft, 0, want);
+    dimensionLeft       -= granted;
+
+    if (granted < want && mLimits.rollover && mSpare > 0) {
+        int take              = std::min(want - granted, mSpare);
+        mSpare               -= take;
+        granted              += take;
+        mCounters.rolledOver += take;
+    }
+
+    if (granted <= 0) {
+        ++mCounters.dimensionCapped;
+        return 0;
+    }
+    if (area) area->left -= granted;
+    return granted;
+}
+
+void BudgetPools::release(int dimension, int chunkX, int chunkZ, int amount) {
+    if (amount == 0) return;
+    int slot = slotOf(dimension);
+    if (auto* area = areaFor(slot, chunkX, chunkZ)) area->left += amount;
+    if (mLimits.dimension <= 0) return;
+    // 关闭之后还回来的额度如果记回维度池就再也用不上了
+    if ((mClosed >> slot) & 1u) mSpare += amount;
+    else mDimensionLeft[slot] += amount;
+}
+
+void BudgetPools::clear() {
+    for (auto& areas : mAreas) areas.clear();
+    mCounters = {};
+    mLastSlot = -1;
+    mVisited  = 0;
+    mClosed   = 0;
+}
+
+BudgetPools::Counters BudgetPools::takeCounters() {
+    Counters counters = mCounters;
+    mCounters         = {};
+    return counters;
+}
+
+size_t BudgetPools::memoryUsage() const noexcept {
+    size_t total = 0;
+    for (auto const& areas : mAreas) total += areas.memoryUsage();
+    return total;
+}
+
+size_t BudgetPools::trackedAreas() const noexcept {
+    size_t total = 0;
+    for (auto const& areas : mAreas) total += areas.size();
+    return total;
+}
+
+} // namespace pending_tick_optimizer
@@ -0,0 +1,70 @@
+#pragma once
+#include "FlatMap.h"
+#include <array>
+#include <cstdint>
+
+namespace pending_tick_optimizer {
+
+// 全局之下的两级预算池：维度池 → 区域池（2^shift × 2^shift 个区块）
+// 全局上限仍由 gTickBudgetRemaining 负责，这里只决定额度在各区域之间如何分配
+// 非线程安全，只在服务器线程上调用：走到预算路径的前提是队列命中策略，而分类只在服务器线程上做
+// rollover 依赖维度在服务器线程上依次 tick：离开过的维度本 tick 不会再回来；
+// 从没调用过 acquire 的维度按 id 顺序（主世界 → 下界 → 末地）判断是否已经 tick 完
+class BudgetPools {
+public:
+    static constexpr int kMaxDimensions = 8;
+
+    struct Limits {
+        int  dimension = 0; // 每维度每 tick 上限，<= 0 不限
+        int  area      = 0; // 每区域每 tick 上限，<= 0 不限
+        int  areaShift = 0;
+        bool rollover  = false; // 已 tick 完的维度把剩余额度让给后面的维度
+    };
+
+    struct Counters {
+        uint64_t dimensionCapped = 0;
+        uint64_t areaCapped      = 0;
+        uint64_t rolledOver      = 0; // 通过 rollover 借到的总量
+    };
+
+    void beginTick(Limits const& limits);
+
+    // 返回本次最多可用的额度（已从池中扣除），want 为期望量
+    int  acquire(int dimension, int chunkX, int chunkZ, int want);
+    // 把没用掉的额度还回去，必须与 acquire 的参数一致；amount 为负表示事后追加扣除
+    // 维度已关闭时记到 mSpare 上，让给之后的维度
+    void release(int dimension, int chunkX, int chunkZ, int amount);
+
+    // 清掉长期没访问的区域并归还容量；会重新分配，在统计任务里调用，不放在 tick 路径上
+    void sweep();
+    void clear();
+
+    [[nodiscard]] Counters        takeCounters();
+    [[nodiscard]] Counters const& counters() const noexcept { return mCounters; }
+    [[nodiscard]] size_t          trackedAreas() const noexcept;
+    [[nodiscard]] size_t          memoryUsage() const noexcept;
+
+private:
+    struct AreaPool {
+        int      left  = 0;
+        uint32_t stamp = 0;
+    };
+
+    [[nodiscard]] uint64_t areaKey(int chunkX, int chunkZ) const noexcept;
+    [[nodiscard]] int      slotOf(int dimension) const noexcept;
+    AreaPool*              areaFor(int slot, int chunkX, int chunkZ);
+    void                   closeDimension(int slot);
+
+    Limits                                       mLimits;
+    uint32_t                                     mStamp = 0;
+    std::array<int, kMaxDimensions> mDimensionLeft{};
+    int                             mSpare    = 0;
+    int                             mLastSlot = -1;
+    uint32_t                        mVisited  = 0; // 本 tick 调用过 acquire 的维度槽位
+    uint32_t                        mClosed   = 0; // 本 tick 已关闭的维度槽位
+    // 每个维度一张表，自定义维度折叠进最后一张
+    std::array<FlatMap<uint64_t, AreaPool>, kMaxDimensions> mAreas;
+    Counters                                                mCounters;
+};
+
+} // namespace pending_tick_optimizer
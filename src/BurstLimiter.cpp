@@ -0,0 +1,67 @@
+#include "BurstLimiter.h"
+#include <algorithm>
+
+namespace pending_tick_optimizer {
+
+void BurstLimiter::beginTick(Settings const& settings) {
+    mSettings               = settings;
+    mSettings.refillPerTick = std::max(1, settings.refillPerTick);
+    mSettings.smoothTicks   = std::max(1, settings.smoothTicks);
+    ++mStamp;
+}
+
+int BurstLimiter::limit(void const* queue, int want, size_t queueSize, bool bucket) {
+    auto* found = mQueues.find(queue);
+    bool  fresh = found == nullptr;
+    auto& entry = fresh ? mQueues[queue] : *found;
+    if (fresh) {
+        // 新队列的桶是满的；积压足够大时改为均摊
+        entry.tokens = mSettings.capacity;
+        entry.stamp  = mStamp;
+        if (mSettings.smoothThreshold > 0 && queueSize >= static_cast<size_t>(mSettings.smoothThreshold)) {
+            auto ticks       = static_cast<size_t>(mSettings.smoothTicks);
+            entry.smoothRate = static_cast<int>(std::max<size_t>(1, (queueSize + ticks - 1) / ticks));
+            entry.smoothLeft = static_cast<uint32_t>(ticks);
+            ++mCounters.smoothed;
+        }
+    } else if (entry.stamp != mStamp) {
+        uint32_t elapsed = mStamp - entry.stamp;
+        entry.tokens     = std::min<int64_t>(
+            mSettings.capacity,
+            entry.tokens + static_cast<int64_t>(elapsed) * mSettings.refillPerTick
+        );
+        entry.stamp = mStamp;
+        if (entry.smoothLeft > 0) {
+            entry.smoothLeft = elapsed >= entry.smoothLeft ? 0 : entry.smoothLeft - elapsed;
+        }
+    }
+
+    int allowed = want;
+    if (entry.smoothLeft > 0) allowed = std::min(allowed, entry.smoothRate);
+    if (bucket && mSettings.capacity > 0) {
+        allowed = std::min<int64_t>(allowed, std::max<int64_t>(0, entry.tokens));
+    }
+    if (allowed < want) {
+        ++mCounters.limited;
+        mCounters.deferred += static_cast<uint64_t>(want - allowed);
+    }
+    return allowed;
+}
+
+void BurstLimiter::consume(void const* queue, int ran) {
+    auto* entry = mQueues.find(queue);
+    if (entry && ran > 0) entry->tokens -= ran;
+}
+
+void BurstLimiter::clear() {
+    mQueues.clear();
+    mCounters = {};
+}
+
+BurstLimiter::Counters BurstLimiter::takeCounters() {
+    Counters counters = mCounters;
+    mCounters         = {};
+    return counters;
+}
+
+} // namespace pending_tick_optimizer
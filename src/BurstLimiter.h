@@ -0,0 +1,60 @@
+#pragma once
+#include "FlatMap.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace pending_tick_optimizer {
+
+// 单队列突发控制：令牌桶 + 新加载积压的平滑
+// 令牌桶按 tick 补充，容量决定能一次吃下多大的突发，补充速率决定稳态下每 tick 的上限；
+// 第一次见到的队列（区块刚加载或刚传送进来）如果已有大量积压，按积压量均摊到若干 tick 里出队
+// 非线程安全，只在服务器线程上调用
+class BurstLimiter {
+public:
+    struct Settings {
+        int capacity        = 0; // 令牌桶容量，<= 0 不启用令牌桶
+        int refillPerTick   = 1; // 每 tick 补充的令牌，至少为 1，保证受限队列总能前进
+        int smoothThreshold = 0; // 首次见到时积压达到 N 才平滑，<= 0 不启用平滑
+        int smoothTicks     = 1; // 积压均摊到的 tick 数
+    };
+
+    struct Counters {
+        uint64_t limited  = 0; // 被令牌桶或平滑压低了上限的调用
+        uint64_t smoothed = 0; // 开始平滑的积压队列数
+        uint64_t deferred = 0; // 因此推迟到后续 tick 的计划刻
+    };
+
+    // 每个 tick 开始时调用，令牌按 tick 差值惰性补充
+    void beginTick(Settings const& settings);
+
+    // 返回本次最多可出队的刻数；bucket 为 false 时只做平滑（放行的队列不受令牌桶约束）
+    int limit(void const* queue, int want, size_t queueSize, bool bucket);
+
+    // 按实际出队数扣令牌，只对受令牌桶约束的调用
+    void consume(void const* queue, int ran);
+
+    void evict(void const* queue) { mQueues.erase(queue); }
+    void clear();
+    void shrink() { mQueues.shrinkToFit(); }
+
+    [[nodiscard]] size_t memoryUsage() const noexcept { return mQueues.memoryUsage(); }
+
+    [[nodiscard]] size_t          queues() const noexcept { return mQueues.size(); }
+    [[nodiscard]] Counters        takeCounters();
+    [[nodiscard]] Counters const& counters() const noexcept { return mCounters; }
+
+private:
+    struct Entry {
+        int64_t  tokens     = 0;
+        uint32_t stamp      = 0; // 最近一次补充令牌的 tick
+        uint32_t smoothLeft = 0; // 平滑剩余的 tick 数，0 表示不在平滑
+        int      smoothRate = 0; // 平滑期间每 tick 的上限
+    };
+
+    Settings                    mSettings;
+    uint32_t                    mStamp = 0;
+    FlatMap<void const*, Entry> mQueues;
+    Counters                    mCounters;
+};
+
+} // namespace pending_tick_optimizer
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+
+namespace pending_tick_optimizer {
+
+struct ChunkCoord {
+    int dimension = 0;
+    int x         = 0;
+    int z         = 0;
+};
+
+// 维度 + 区块坐标打包成 64 位键：1 位标记 | 7 位维度 | 28 位 x | 28 位 z
+// 最高位恒为 1，不会与 FlatMap 的空键冲突
+[[nodiscard]] inline uint64_t packChunkKey(int dimension, int chunkX, int chunkZ) noexcept {
+    return (1ULL << 63) | (static_cast<uint64_t>(dimension & 0x7f) << 56)
+         | (static_cast<uint64_t>(static_cast<uint32_t>(chunkX) & 0xfffffffu) << 28)
+         | (static_cast<uint32_t>(chunkZ) & 0xfffffffu);
+}
+
+[[nodiscard]] inline ChunkCoord unpackChunkKey(uint64_t key) noexcept {
+    // 28 位补码符号扩展
+    auto signExtend = [](uint64_t bits) { return static_cast<int>(static_cast<int32_t>(bits << 4) >> 4); };
+    return {
+        .dimension = static_cast<int>((key >> 56) & 0x7f),
+        .x         = signExtend((key >> 28) & 0xfffffffu),
+        .z         = signExtend(key & 0xfffffffu),
+    };
+}
+
+} // namespace pending_tick_optimizer
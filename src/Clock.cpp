@@ -0,0 +1,30 @@
+#include "Clock.h"
+#include <atomic>
+#include <thread>
+
+namespace pending_tick_optimizer {
+
+static std::atomic<double> nsPerTick{1.0};
+
+void calibrateTsc(int sampleMs) {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    auto     wallBegin = std::chrono::steady_clock::now();
+    uint64_t tscBegin  = readTsc();
+    std::this_thread::sleep_for(std::chrono::milliseconds(sampleMs > 0 ? sampleMs : 20));
+    uint64_t tscEnd  = readTsc();
+    auto     wallEnd = std::chrono::steady_clock::now();
+
+    double wallNs = std::chrono::duration<double, std::nano>(wallEnd - wallBegin).count();
+    if (tscEnd > tscBegin && wallNs > 0.0) {
+        nsPerTick.store(wallNs / static_cast<double>(tscEnd - tscBegin), std::memory_order_relaxed);
+    }
+#else
+    // steady_clock 的计数单位换算成纳秒
+    using Period = std::chrono::steady_clock::period;
+    nsPerTick.store(1e9 * Period::num / Period::den, std::memory_order_relaxed);
+#endif
+}
+
+double tscNsPerTick() noexcept { return nsPerTick.load(std::memory_order_relaxed); }
+
+} // namespace pending_tick_optimizer
@@ -0,0 +1,29 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace pending_tick_optimizer {
+
+// 热路径计时：x86 上直接读 TSC，开销只有几纳秒；其它平台退回 steady_clock
+[[nodiscard]] inline uint64_t readTsc() noexcept {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// 用 steady_clock 校准 TSC 频率，阻塞约 sampleMs 毫秒，加载时调用一次即可
+void calibrateTsc(int sampleMs = 20);
+
+// 每个 TSC 计数对应的纳秒数，未校准时为 1
+[[nodiscard]] double tscNsPerTick() noexcept;
+
+[[nodiscard]] inline double tscToNs(uint64_t ticks) noexcept { return static_cast<double>(ticks) * tscNsPerTick(); }
+
+} // namespace pending_tick_optimizer
@@ -0,0 +1,245 @@
+#include "Command.h"
+#include "Benchmark.h"
+#include "PendingTickOptimizer.h"
+#include "ll/api/command/CommandHandle.h"
+#include "ll/api/command/CommandRegistrar.h"
+#include "mc/server/commands/CommandOrigin.h"
+#include "mc/server/commands/CommandOutput.h"
+#include "mc/server/commands/CommandPermissionLevel.h"
+#include "mc/world/actor/Actor.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace pending_tick_optimizer {
+
+// 枚举值名即命令里的关键字
+enum class BudgetField { perCall, global, dimension, area, starvationReserve, nearReserve };
+enum class PolicyField { enabled, perCall, perTick };
+enum class ProfileAction { show, dump, reset };
+enum class BenchAction { stop, clear };
+enum class TraceAction { show, start, stop };
+
+struct BudgetParams {
+    BudgetField field;
+    int         value;
+};
+
+struct PolicyParams {
+    std::string name;
+    PolicyField field;
+    int         value;
+};
+
+struct ProfileParams {
+    ProfileAction action = ProfileAction::show;
+};
+
+struct BenchActionParams {
+    BenchAction action;
+};
+
+struct TraceParams {
+    TraceAction action = TraceAction::show;
+};
+
+static void print(CommandOutput& output, std::vector<std::string> const& lines) {
+    for (auto const& line : lines) output.success(line);
+}
+
+// 命令都在服务器线程上执行：改编辑副本，再发布新快照
+static void setBudget(BudgetField field, int value) {
+    auto& cfg = getConfig();
+    switch (field) {
+    case BudgetField::perCall:
+        cfg.budgetPerTick = std::max(1, value);
+        break;
+    case BudgetField::global:
+        cfg.globalBudgetPerTick = std::max(1, value);
+        break;
+    case BudgetField::dimension:
+        cfg.dimensionBudgetPerTick = value;
+        break;
+    case BudgetField::area:
+        cfg.areaBudgetPerTick = value;
+        break;
+    case BudgetField::starvationReserve:
+        cfg.starvationReservePct = std::clamp(value, 0, 100);
+        break;
+    case BudgetField::nearReserve:
+        cfg.nearReservePct = std::clamp(value, 0, 100);
+        break;
+    }
+    publishConfig();
+}
+
+static bool setPolicy(std::string const& name, PolicyField field, int value) {
+    auto& policies = getConfig().policies;
+    auto  it       = std::find_if(policies.begin(), policies.end(), [&name](auto const& policy) {
+        return policy.name == name;
+    });
+    if (it == policies.end()) return false;
+    switch (field) {
+    case PolicyField::enabled:
+        it->enabled = value != 0;
+        break;
+    case PolicyField::perCall:
+        it->budgetPerCall = std::max(0, value);
+        break;
+    case PolicyField::perTick:
+        it->globalBudgetPerTick = std::max(0, value);
+        break;
+    }
+    publishConfig();
+    return true;
+}
+
+void registerCommand() {
+    static bool registered = false;
+    if (registered) return;
+    registered = true;
+
+    auto& command = ll::command::CommandRegistrar::getInstance().getOrCreateCommand(
+        "pto",
+        "PendingTickOptimizer stats and runtime tuning",
+        CommandPermissionLevel::GameDirectors
+    );
+
+    command.overload().text("stats").execute([](CommandOrigin const&, CommandOutput& output) {
+        print(output, statsReport(false));
+    });
+
+    command.overload().text("budget").execute([](CommandOrigin const&, CommandOutput& output) {
+        print(output, budgetReport());
+    });
+    command.overload<BudgetParams>()
+        .text("budget")
+        .required("field")
+        .required("value")
+        .execute([](CommandOrigin const&, CommandOutput& output, BudgetParams const& params) {
+            setBudget(params.field, params.value);
+            print(output, budgetReport());
+        });
+
+    command.overload().text("policy").execute([](CommandOrigin const&, CommandOutput& output) {
+        print(output, policyReport());
+    });
+    command.overload<PolicyParams>()
+        .text("policy")
+        .required("name")
+        .required("field")
+        .required("value")
+        .execute([](CommandOrigin const&, CommandOutput& output, PolicyParams const& params) {
+            if (!setPolicy(params.name, params.field, params.value)) {
+                output.error("Unknown policy: " + params.name);
+                return;
+            }
+            print(output, policyReport());
+        });
+
+    command.overload<ProfileParams>()
+        .text("profile")
+        .optional("action")
+        .execute([](CommandOrigin const&, CommandOutput& output, ProfileParams const& params) {
+            switch (params.action) {
+            case ProfileAction::show: {
+                auto lines = hotSpotReport(static_cast<size_t>(std::max(1, currentConfig().profilerLogTop)));
+                if (lines.empty()) {
+                    output.success(currentConfig().profilerEnabled ? "No hot spots recorded yet" : "Profiler is disabled");
+                }
+                print(output, lines);
+                break;
+            }
+            case ProfileAction::dump:
+                if (dumpHotSpots()) {
+                    output.success("Hot spots written to hotspots.json");
+                } else {
+                    output.error("Failed to write hotspots.json");
+                }
+                break;
+            case ProfileAction::reset:
+                resetHotSpots();
+                output.success("Hot spots cleared");
+                break;
+            }
+        });
+
+    // 压测在执行者附近搭建场景，必须由玩家执行；报告写到日志和数据目录
+    command.overload<BenchmarkScenario>()
+        .text("bench")
+        .optional("ticks")
+        .optional("portals")
+        .optional("clocks")
+        .optional("fluids")
+        .optional("warmupTicks")
+        .execute([](CommandOrigin const& origin, CommandOutput& output, BenchmarkScenario const& scenario) {
+            auto* actor = origin.getEntity();
+            if (!actor) {
+                output.error("Benchmark must be run by a player");
+                return;
+            }
+            if (benchmarkRunning()) {
+                output.error("A benchmark is already running");
+                return;
+            }
+            if (!startBenchmark(*actor, scenario)) {
+                output.error("Failed to build the benchmark scenario, the area above you must be loaded and empty (see log)");
+                return;
+            }
+            output.success("Benchmark started, the report is logged when it finishes");
+        });
+    command.overload<BenchActionParams>()
+        .text("bench")
+        .required("action")
+        .execute([](CommandOrigin const& origin, CommandOutput& output, BenchActionParams const& params) {
+            switch (params.action) {
+            case BenchAction::stop:
+                if (!benchmarkRunning()) {
+                    output.error("No benchmark is running");
+                    return;
+                }
+                stopBenchmark();
+                output.success("Benchmark stopped");
+                break;
+            case BenchAction::clear: {
+                auto* actor = origin.getEntity();
+                if (!actor) {
+                    output.error("Benchmark must be run by a player");
+                    return;
+                }
+                output.success("Restored " + std::to_string(clearBenchmark(*actor)) + " blocks");
+                break;
+            }
+            }
+        });
+
+    // 开关录制走配置快照，与改 traceEnabled 后 reload 等价
+    command.overload<TraceParams>()
+        .text("trace")
+        .optional("action")
+        .execute([](CommandOrigin const&, CommandOutput& output, TraceParams const& params) {
+            if (params.action != TraceAction::show) {
+                getConfig().traceEnabled = params.action == TraceAction::start;
+                publishConfig();
+            }
+            print(output, traceReport());
+        });
+
+    command.overload().text("reload").execute([](CommandOrigin const&, CommandOutput& output) {
+        if (reloadConfig()) {
+            output.success("Config reloaded");
+        } else {
+            output.error("Failed to reload config, keeping the current one");
+        }
+    });
+    // 运行时的修改默认只在内存里，save 才写回 config.json
+    command.overload().text("save").execute([](CommandOrigin const&, CommandOutput& output) {
+        if (saveConfig()) {
+            output.success("Config saved");
+        } else {
+            output.error("Failed to save config");
+        }
+    });
+}
+
+} // namespace pending_tick_optimizer
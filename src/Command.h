@@ -0,0 +1,8 @@
+#pragma once
+
+namespace pending_tick_optimizer {
+
+// 注册 /pto 命令，重复调用只注册一次
+void registerCommand();
+
+} // namespace pending_tick_optimizer
@@ -0,0 +1,122 @@
+#include "CostModel.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <nlohmann/json.hpp>
+
+namespace pending_tick_optimizer {
+
+// 样本太少时估计不稳定，先按 1 个单位计
+static constexpr uint64_t kMinSamples = 8;
+static constexpr double   kAlpha      = 0.05;
+
+uint32_t CostModel::typeSlot(std::string_view name) {
+    for (uint32_t i = 0; i < mTypes.size(); ++i) {
+        if (mTypes[i].name == name) return i;
+    }
+    mTypes.push_back({.name = std::string(name)});
+    return static_cast<uint32_t>(mTypes.size() - 1);
+}
+
+double CostModel::costNs(uint32_t type) const noexcept {
+    if (type >= mTypes.size() || mTypes[type].samples < kMinSamples) return 0.0;
+    return mTypes[type].ns;
+}
+
+size_t CostModel::memoryUsage() const noexcept {
+    size_t total = mTypes.capacity() * sizeof(TypeCost) + mBlocks.memoryUsage();
+    for (auto const& type : mTypes) total += type.name.capacity();
+    return total;
+}
+
+std::string const& CostModel::nameOf(uint32_t type) const noexcept {
+    static std::string const unknown;
+    return type < mTypes.size() ? mTypes[type].name : unknown;
+}
+
+double CostModel::weightFor(double costNs, Settings const& settings) noexcept {
+    if (costNs <= 0.0 || settings.unitNs <= 0.0) return 1.0;
+    return std::clamp(costNs / settings.unitNs, settings.minWeight, settings.maxWeight);
+}
+
+void CostModel::record(uint32_t type, double elapsedNs, int processed) {
+    if (type >= mTypes.size() || processed <= 0) return;
+    auto&  entry  = mTypes[type];
+    double sample = elapsedNs / processed;
+    // 前几个样本用算术平均快速收敛，之后转为 EWMA
+    if (entry.samples < kMinSamples) {
+        entry.ns = (entry.ns * static_cast<double>(entry.samples) + sample) / static_cast<double>(entry.samples + 1);
+    } else {
+        entry.ns += (sample - entry.ns) * kAlpha;
+    }
+    ++entry.samples;
+}
+
+bool CostModel::load(std::filesystem::path const& path) {
+    std::ifstream file(path);
+    if (!file) return false;
+    auto json = nlohmann::json::parse(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>(), nullptr, false);
+    if (json.is_discarded() || !json.is_object()) return false;
+    auto types = json.find("types");
+    if (types == json.end() || !types->is_object()) return false;
+
+    for (auto it = types->begin(); it != types->end(); ++it) {
+        auto const& value = it.value();
+        if (!value.is_object()) continue;
+        auto ns      = value.find("ns");
+        auto samples = value.find("samples");
+        if (ns == value.end() || !ns->is_number() || samples == value.end() || !samples->is_number_unsigned()) {
+            continue;
+        }
+        auto& entry   = mTypes[typeSlot(it.key())];
+        entry.ns      = ns->get<double>();
+        entry.samples = samples->get<uint64_t>();
+    }
+    return true;
+}
+
+void CostModel::restore(std::vector<TypeCost> const& types) {
+    for (auto const& type : types) {
+        if (type.samples == 0) continue;
+        auto& entry   = mTypes[typeSlot(type.name)];
+        entry.ns      = type.ns;
+        entry.samples = type.samples;
+    }
+}
+
+bool CostModel::save(std::filesystem::path const& path) const {
+    nlohmann::json types = nlohmann::json::object();
+    for (auto const& entry : mTypes) {
+        if (entry.samples == 0) continue;
+        types[entry.name] = {
+            {"ns",      entry.ns     },
+            {"samples", entry.samples},
+        };
+    }
+    nlohmann::json out{
+        {"version", 1              },
+        {"types",   std::move(types)},
+    };
+
+    // 先写临时文件再替换，避免关服时写到一半留下损坏的文件
+    auto          temp = std::filesystem::path(path).concat(".tmp");
+    std::ofstream file(temp);
+    file << out.dump(4);
+    file.close();
+    if (!file) return false;
+    std::error_code ec;
+    std::filesystem::rename(temp, path, ec);
+    return !ec;
+}
+
+std::vector<CostModel::TypeCost> CostModel::top(size_t n) const {
+    std::vector<TypeCost> result = mTypes;
+    n                            = std::min(n, result.size());
+    std::partial_sort(result.begin(), result.begin() + static_cast<ptrdiff_t>(n), result.end(), [](auto& a, auto& b) {
+        return a.samples > b.samples;
+    });
+    result.resize(n);
+    return result;
+}
+
+} // namespace pending_tick_optimizer
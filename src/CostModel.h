@@ -0,0 +1,70 @@
+#pragma once
+#include "FlatMap.h"
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pending_tick_optimizer {
+
+// 按方块类型在线学习单个计划刻的平均耗时（EWMA），并折算成预算的成本单位
+// 方块状态按 Block 指针缓存到类型槽，同一类型的不同状态共享一份估计
+// 非线程安全，只在服务器线程上调用
+class CostModel {
+public:
+    static constexpr uint32_t kNoType = UINT32_MAX;
+
+    struct Settings {
+        double unitNs    = 2000.0; // 1 个成本单位对应的耗时
+        double minWeight = 0.25;
+        double maxWeight = 8.0;
+    };
+
+    struct TypeCost {
+        std::string name;
+        double      ns      = 0.0; // 平滑后的单刻耗时
+        uint64_t    samples = 0;
+    };
+
+    // typeNameOf 只在缓存未命中时调用
+    template <class NameFn>
+    uint32_t typeOf(void const* block, NameFn&& typeNameOf) {
+        if (!block) return kNoType;
+        if (auto* cached = mBlocks.find(block)) return *cached;
+        uint32_t type  = typeSlot(typeNameOf());
+        mBlocks[block] = type;
+        return type;
+    }
+
+    // 没有足够样本时返回 0，调用方按未知处理
+    [[nodiscard]] double costNs(uint32_t type) const noexcept;
+    // 单刻按多少个成本单位计，未知类型按 1
+    [[nodiscard]] double weight(uint32_t type, Settings const& settings) const noexcept {
+        return weightFor(costNs(type), settings);
+    }
+    [[nodiscard]] static double weightFor(double costNs, Settings const& settings) noexcept;
+
+    // 未知编号返回空串
+    [[nodiscard]] std::string const& nameOf(uint32_t type) const noexcept;
+
+    void record(uint32_t type, double elapsedNs, int processed);
+
+    bool load(std::filesystem::path const& path);
+    bool save(std::filesystem::path const& path) const;
+    // 用世界档案里的估计覆盖同名类型，没有样本的条目忽略
+    void restore(std::vector<TypeCost> const& types);
+
+    // 按样本数从多到少返回前 n 个类型
+    [[nodiscard]] std::vector<TypeCost> top(size_t n) const;
+    [[nodiscard]] size_t                types() const noexcept { return mTypes.size(); }
+    [[nodiscard]] size_t                memoryUsage() const noexcept;
+
+private:
+    uint32_t typeSlot(std::string_view name);
+
+    std::vector<TypeCost>          mTypes;
+    FlatMap<void const*, uint32_t> mBlocks;
+};
+
+} // namespace pending_tick_optimizer
@@ -0,0 +1,152 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pending_tick_optimizer {
+
+// 开放寻址哈希表（线性探测 + 回移删除）
+// 键为指针或整数，K{} 保留为空槽标记，调用方需保证不会插入 K{}
+// 非线程安全，只在单一线程（服务器线程）上使用
+template <class K, class V>
+class FlatMap {
+    static_assert(std::is_trivially_copyable_v<K> && sizeof(K) <= sizeof(uint64_t));
+
+public:
+    [[nodiscard]] V* find(K key) noexcept {
+        if (mSize == 0) return nullptr;
+        for (size_t i = slotOf(key);; i = (i + 1) & mMask) {
+            auto& slot = mSlots[i];
+            if (slot.key == key) return &slot.value;
+            if (slot.key == K{}) return nullptr;
+        }
+    }
+
+    V& operator[](K key) {
+        if (auto* value = find(key)) return *value;
+        if ((mSize + 1) * 4 > mSlots.size() * 3) grow();
+        size_t i = slotOf(key);
+        while (mSlots[i].key != K{}) i = (i + 1) & mMask;
+        mSlots[i].key   = key;
+        mSlots[i].value = V{};
+        ++mSize;
+        return mSlots[i].value;
+    }
+
+    bool erase(K key) noexcept {
+        if (mSize == 0) return false;
+        size_t i = slotOf(key);
+        while (mSlots[i].key != key) {
+            if (mSlots[i].key == K{}) return false;
+            i = (i + 1) & mMask;
+        }
+        // 回移删除：把后续簇内元素前移，保持探测链连续，无需墓碑
+        for (size_t j = (i + 1) & mMask; mSlots[j].key != K{}; j = (j + 1) & mMask) {
+            size_t home = slotOf(mSlots[j].key);
+            if (((j - home) & mMask) >= ((j - i) & mMask)) {
+                mSlots[i] = std::move(mSlots[j]);
+                i         = j;
+            }
+        }
+        mSlots[i].key   = K{};
+        mSlots[i].value = V{};
+        --mSize;
+        return true;
+    }
+
+    template <class Pred>
+    size_t eraseIf(Pred&& pred) {
+        size_t erased = 0;
+        for (size_t i = 0; i < mSlots.size();) {
+            auto& slot = mSlots[i];
+            // 回移会把后面的元素挪到 i，需要重新检查当前位置
+            if (slot.key != K{} && pred(slot.key, slot.value)) {
+                erase(slot.key);
+                ++erased;
+            } else {
+                ++i;
+            }
+        }
+        return erased;
+    }
+
+    template <class Fn>
+    void forEach(Fn&& fn) {
+        for (auto& slot : mSlots) {
+            if (slot.key != K{}) fn(slot.key, slot.value);
+        }
+    }
+
+    void clear() noexcept {
+        for (auto& slot : mSlots) slot = Slot{};
+        mSize = 0;
+    }
+
+    void reserve(size_t count) {
+        while (count * 4 > mSlots.size() * 3) grow();
+    }
+
+    // 按当前元素数重建成能装下它们的最小容量，大量驱逐之后归还内存；会使已取得的指针失效
+    void shrinkToFit() {
+        if (mSize == 0) {
+            mSlots = {};
+            mMask  = 0;
+            return;
+        }
+        size_t cap = 16;
+        while (mSize * 4 > cap * 3) cap *= 2;
+        if (cap >= mSlots.size()) return;
+        rehash(cap);
+    }
+
+    [[nodiscard]] size_t size() const noexcept { return mSize; }
+    [[nodiscard]] size_t capacity() const noexcept { return mSlots.size(); }
+    [[nodiscard]] size_t memoryUsage() const noexcept { return mSlots.capacity() * sizeof(Slot); }
+
+private:
+    struct Slot {
+        K key{};
+        V value{};
+    };
+
+    [[nodiscard]] size_t slotOf(K key) const noexcept {
+        uint64_t x;
+        if constexpr (std::is_pointer_v<K>) {
+            x = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(key));
+        } else {
+            x = static_cast<uint64_t>(key);
+        }
+        // splitmix64 finalizer，指针低位对齐带来的规律性会被打散
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        return static_cast<size_t>(x) & mMask;
+    }
+
+    void grow() { rehash(mSlots.empty() ? 16 : mSlots.size() * 2); }
+
+    void rehash(size_t cap) {
+        std::vector<Slot> old = std::move(mSlots);
+        mSlots                = {};
+        mSlots.assign(cap, Slot{});
+        mMask = cap - 1;
+        mSize = 0;
+        for (auto& slot : old) {
+            if (slot.key == K{}) continue;
+            size_t i = slotOf(slot.key);
+            while (mSlots[i].key != K{}) i = (i + 1) & mMask;
+            mSlots[i] = std::move(slot);
+            ++mSize;
+        }
+    }
+
+    std::vector<Slot> mSlots;
+    size_t            mSize = 0;
+    size_t            mMask = 0;
+};
+
+} // namespace pending_tick_optimizer
@@ -0,0 +1,69 @@
+#include "HotSpotTracker.h"
+#include <algorithm>
+
+namespace pending_tick_optimizer {
+
+void HotSpotTracker::setCapacity(size_t capacity) {
+    mCapacity = std::max<size_t>(1, capacity);
+    clear();
+    mEntries.reserve(mCapacity);
+    mIndex.reserve(mCapacity);
+}
+
+void HotSpotTracker::record(uint64_t key, double cost, uint64_t ticks) {
+    if (auto* index = mIndex.find(key)) {
+        auto& entry  = mEntries[*index];
+        entry.cost  += cost;
+        entry.ticks += ticks;
+        ++entry.calls;
+        return;
+    }
+    if (mEntries.size() < mCapacity) {
+        mIndex[key] = mEntries.size();
+        mEntries.push_back({.key = key, .cost = cost, .ticks = ticks, .calls = 1});
+        return;
+    }
+    // 容量很小（几十个），线性找最小值比维护堆更划算
+    auto victim = std::min_element(mEntries.begin(), mEntries.end(), [](Entry const& a, Entry const& b) {
+        return a.cost < b.cost;
+    });
+    mIndex.erase(victim->key);
+    mIndex[key] = static_cast<size_t>(victim - mEntries.begin());
+
+    double inherited = victim->cost;
+    *victim          = {.key = key, .cost = inherited + cost, .error = inherited, .ticks = ticks, .calls = 1};
+}
+
+std::vector<HotSpotTracker::Entry> HotSpotTracker::top(size_t n) const {
+    std::vector<Entry> result = mEntries;
+    n                         = std::min(n, result.size());
+    std::partial_sort(result.begin(), result.begin() + static_cast<ptrdiff_t>(n), result.end(), [](auto& a, auto& b) {
+        return a.cost > b.cost;
+    });
+    result.resize(n);
+    return result;
+}
+
+void HotSpotTracker::decay(double factor) {
+    for (auto& entry : mEntries) {
+        entry.cost  *= factor;
+        entry.error *= factor;
+    }
+}
+
+void HotSpotTracker::clear() {
+    mEntries.clear();
+    mIndex.clear();
+}
+
+void HotSpotTracker::restore(std::vector<Entry> const& entries) {
+    clear();
+    for (auto const& entry : entries) {
+        if (mEntries.size() >= mCapacity) break;
+        if (entry.key == 0 || mIndex.find(entry.key)) continue;
+        mIndex[entry.key] = mEntries.size();
+        mEntries.push_back(entry);
+    }
+}
+
+} // namespace pending_tick_optimizer
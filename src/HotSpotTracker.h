@@ -0,0 +1,44 @@
+#pragma once
+#include "FlatMap.h"
+#include <cstdint>
+#include <vector>
+
+namespace pending_tick_optimizer {
+
+// Space-Saving 热点统计：固定容量，满了以后新键顶替当前代价最小的条目，
+// 并继承其代价作为误差上界。真正的重负载区块一定会留在表里。
+// 只在服务器线程上调用
+class HotSpotTracker {
+public:
+    struct Entry {
+        uint64_t key   = 0;   // packChunkKey
+        double   cost  = 0.0; // 累计耗时（纳秒，已按采样率放大）
+        double   error = 0.0; // 顶替时继承的代价，cost - error 是可信下界
+        uint64_t ticks = 0;   // 累计处理的计划刻数
+        uint64_t calls = 0;
+    };
+
+    void setCapacity(size_t capacity);
+    void record(uint64_t key, double cost, uint64_t ticks);
+
+    // 按代价从高到低返回前 n 个
+    [[nodiscard]] std::vector<Entry> top(size_t n) const;
+
+    // 统计周期结束时整体衰减，让报告反映最近的负载
+    void decay(double factor);
+    void clear();
+    // 用保存的条目重新填表，超出容量的部分丢弃
+    void restore(std::vector<Entry> const& entries);
+
+    [[nodiscard]] size_t size() const noexcept { return mEntries.size(); }
+    [[nodiscard]] size_t memoryUsage() const noexcept {
+        return mEntries.capacity() * sizeof(Entry) + mIndex.memoryUsage();
+    }
+
+private:
+    size_t                    mCapacity = 64;
+    std::vector<Entry>        mEntries;
+    FlatMap<uint64_t, size_t> mIndex;
+};
+
+} // namespace pending_tick_optimizer
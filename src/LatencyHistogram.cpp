@@ -0,0 +1,51 @@
+#include "LatencyHistogram.h"
+
+namespace pending_tick_optimizer {
+
+double LatencyHistogram::valueOf(int bucket) noexcept {
+    if (bucket < kSubBuckets) return bucket;
+    int    exp   = bucket / kSubBuckets + kSubBits - 1;
+    int    sub   = bucket % kSubBuckets;
+    double width = static_cast<double>(1ULL << (exp - kSubBits));
+    double lower = static_cast<double>(1ULL << exp) + sub * width;
+    return lower + width / 2.0;
+}
+
+LatencyHistogram::Summary LatencyHistogram::summarize(double scale, bool reset) {
+    auto read = [reset](std::atomic<uint64_t>& value) {
+        return reset ? value.exchange(0, std::memory_order_relaxed) : value.load(std::memory_order_relaxed);
+    };
+    std::array<uint64_t, kBuckets> counts;
+    uint64_t                       total = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        counts[i]  = read(mBuckets[i]);
+        total     += counts[i];
+    }
+    uint64_t sum = read(mSum);
+    uint64_t max = read(mMax);
+
+    Summary summary;
+    summary.count = total;
+    if (total == 0) return summary;
+
+    // 按秩找分位点，目标秩向上取整
+    auto rankOf = [total](double q) { return static_cast<uint64_t>(q * static_cast<double>(total - 1)) + 1; };
+    uint64_t const ranks[] = {rankOf(0.5), rankOf(0.99), rankOf(0.999)};
+    double*        outs[]  = {&summary.p50, &summary.p99, &summary.p999};
+
+    uint64_t seen = 0;
+    int      next = 0;
+    for (int i = 0; i < kBuckets && next < 3; ++i) {
+        seen += counts[i];
+        while (next < 3 && seen >= ranks[next]) *outs[next++] = valueOf(i) * scale;
+    }
+    summary.max  = static_cast<double>(max) * scale;
+    summary.mean = static_cast<double>(sum) / static_cast<double>(total) * scale;
+    // 代表值取的是区间中点，可能略大于真实最大值
+    if (summary.p999 > summary.max) summary.p999 = summary.max;
+    if (summary.p99 > summary.max) summary.p99 = summary.max;
+    if (summary.p50 > summary.max) summary.p50 = summary.max;
+    return summary;
+}
+
+} // namespace pending_tick_optimizer
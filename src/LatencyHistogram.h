@@ -0,0 +1,59 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+
+namespace pending_tick_optimizer {
+
+// HDR 风格的对数-线性直方图：每个 2 的幂区间再均分 16 格，相对误差不超过 1/16
+// 记录只有一次 lzcnt 和一次 relaxed fetch_add，可以多线程同时写
+// 数值单位由调用方决定（热路径直接记录 TSC 计数，汇总时再换算）
+class LatencyHistogram {
+public:
+    static constexpr int kSubBits    = 4;
+    static constexpr int kSubBuckets = 1 << kSubBits;
+    static constexpr int kMaxExp     = 48; // 覆盖到 2^48，换算成纳秒远超任何一次调用
+    static constexpr int kBuckets    = (kMaxExp - kSubBits + 2) * kSubBuckets;
+
+    struct Summary {
+        uint64_t count = 0;
+        double   p50   = 0.0;
+        double   p99   = 0.0;
+        double   p999  = 0.0;
+        double   max   = 0.0;
+        double   mean  = 0.0;
+    };
+
+    void record(uint64_t value) noexcept {
+        mBuckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+        mSum.fetch_add(value, std::memory_order_relaxed);
+        uint64_t seen = mMax.load(std::memory_order_relaxed);
+        while (value > seen && !mMax.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+    }
+
+    // 取出当前分布并清零；scale 把记录单位换算成输出单位
+    [[nodiscard]] Summary takeSummary(double scale) { return summarize(scale, true); }
+    // 只读当前分布，不清零
+    [[nodiscard]] Summary peekSummary(double scale) { return summarize(scale, false); }
+
+    [[nodiscard]] static int bucketOf(uint64_t value) noexcept {
+        if (value < kSubBuckets) return static_cast<int>(value);
+        int exp = std::bit_width(value) - 1;
+        if (exp > kMaxExp) return kBuckets - 1;
+        int sub = static_cast<int>((value >> (exp - kSubBits)) & (kSubBuckets - 1));
+        return (exp - kSubBits + 1) * kSubBuckets + sub;
+    }
+
+    // 桶的代表值（区间中点）
+    [[nodiscard]] static double valueOf(int bucket) noexcept;
+
+private:
+    Summary summarize(double scale, bool reset);
+
+    std::array<std::atomic<uint64_t>, kBuckets> mBuckets{};
+    std::atomic<uint64_t>                       mSum{0};
+    std::atomic<uint64_t>                       mMax{0};
+};
+
+} // namespace pending_tick_optimizer
@@ -0,0 +1,137 @@
+#include "LoadAttribution.h"
+#include "ChunkKey.h"
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+namespace pending_tick_optimizer {
+
+uint32_t LoadAttribution::playerId(std::string const& name) {
+    auto [it, inserted] = mIds.try_emplace(name, static_cast<uint32_t>(mPlayers.size() + 1));
+    if (inserted) mPlayers.push_back({.name = name});
+    return it->second;
+}
+
+LoadAttribution::PlayerLoad LoadAttribution::loadOf(PlayerState const& state) {
+    return {
+        .name    = state.name,
+        .loadMs  = state.loadMs,
+        .chunks  = state.chunks,
+        .placed  = state.placed,
+        .flagged = state.flagged,
+    };
+}
+
+uint32_t LoadAttribution::nearestPlayer(int dimension, int chunkX, int chunkZ, int radius) const {
+    uint32_t best     = kNoPlayer;
+    int      bestDist = radius + 1;
+    for (auto const& pos : mPositions) {
+        if (pos.dimension != dimension) continue;
+        int dist = std::max(std::abs(pos.chunkX - chunkX), std::abs(pos.chunkZ - chunkZ));
+        if (dist < bestDist) {
+            best     = pos.player;
+            bestDist = dist;
+        }
+    }
+    return best;
+}
+
+std::vector<LoadAttribution::PlayerLoad>
+LoadAttribution::attribute(std::vector<HotSpotTracker::Entry> const& spots, Settings const& settings, uint32_t now) {
+    for (auto& player : mPlayers) {
+        player.loadMs = 0.0;
+        player.chunks = 0;
+        player.placed = 0;
+    }
+
+    // 先算分数，之后才知道谁被标记，惩罚档要在第二遍里按归属重建
+    std::vector<std::pair<uint64_t, uint32_t>> owners;
+    owners.reserve(spots.size());
+    for (auto const& spot : spots) {
+        // 用 Space-Saving 的可信下界，刚顶替进表的条目不会因为继承的误差被算到谁头上
+        double loadMs = (spot.cost - spot.error) / 1e6;
+        if (loadMs <= 0.0) continue;
+
+        uint32_t owner  = kNoPlayer;
+        bool     placed = false;
+        if (auto* placement = mPlacements.find(spot.key); placement && now - placement->tick <= settings.placementWindow) {
+            owner  = placement->player;
+            placed = true;
+        } else {
+            auto chunk = unpackChunkKey(spot.key);
+            owner      = nearestPlayer(chunk.dimension, chunk.x, chunk.z, settings.nearbyRadius);
+        }
+        if (owner == kNoPlayer) {
+            ++mCounters.unattributed;
+            continue;
+        }
+
+        auto& state   = mPlayers[owner - 1];
+        state.loadMs += loadMs;
+        ++state.chunks;
+        if (placed) ++state.placed;
+        owners.emplace_back(spot.key, owner);
+    }
+
+    std::vector<PlayerLoad> changes;
+    mFlagged = 0;
+    for (auto& state : mPlayers) {
+        bool was = state.flagged;
+        if (!was && state.loadMs >= settings.flagMs) {
+            state.flagged = true;
+            ++mCounters.flags;
+        } else if (was && state.loadMs < settings.flagMs * 0.5) {
+            state.flagged = false;
+        }
+        if (state.flagged != was) changes.push_back(loadOf(state));
+        if (state.flagged) ++mFlagged;
+    }
+
+    mPenalized.clear();
+    for (auto const& [key, owner] : owners) {
+        if (mPlayers[owner - 1].flagged) mPenalized[key] = owner;
+    }
+    return changes;
+}
+
+std::vector<LoadAttribution::PlayerLoad> LoadAttribution::top(size_t n) const {
+    std::vector<PlayerLoad> result;
+    for (auto const& state : mPlayers) {
+        if (state.chunks > 0 || state.flagged) result.push_back(loadOf(state));
+    }
+    n = std::min(n, result.size());
+    std::partial_sort(result.begin(), result.begin() + static_cast<ptrdiff_t>(n), result.end(), [](auto& a, auto& b) {
+        return a.loadMs > b.loadMs;
+    });
+    result.resize(n);
+    return result;
+}
+
+LoadAttribution::Counters LoadAttribution::takeCounters() noexcept { return std::exchange(mCounters, {}); }
+
+void LoadAttribution::expire(uint32_t now, uint32_t window) {
+    mPlacements.eraseIf([&](uint64_t, Placement const& placement) { return now - placement.tick > window; });
+    mPlacements.shrinkToFit();
+}
+
+void LoadAttribution::clear() {
+    mPlacements = {};
+    mPenalized  = {};
+    mPositions.clear();
+    mPlayers.clear();
+    mIds.clear();
+    mFlagged  = 0;
+    mCounters = {};
+}
+
+size_t LoadAttribution::memoryUsage() const noexcept {
+    size_t names = 0;
+    for (auto const& state : mPlayers) names += state.name.capacity();
+    // unordered_map 的节点开销按键值大小加两个指针估计
+    return mPlacements.memoryUsage() + mPenalized.memoryUsage() + mPositions.capacity() * sizeof(Position)
+         + mPlayers.capacity() * sizeof(PlayerState) + names * 2
+         + mIds.size() * (sizeof(std::pair<std::string, uint32_t>) + 2 * sizeof(void*))
+         + mIds.bucket_count() * sizeof(void*);
+}
+
+} // namespace pending_tick_optimizer
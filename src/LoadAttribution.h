@@ -0,0 +1,108 @@
+#pragma once
+#include "FlatMap.h"
+#include "HotSpotTracker.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pending_tick_optimizer {
+
+// 负载归属：把热点区块记到玩家名下，用来发现专门刷计划刻的卡服机器
+// 优先归给窗口期内最后一个在该区块放置方块的玩家，没有放置记录时归给同维度半径内最近的在线玩家
+// 每个统计周期按热点表重新计算；热点表本身按周期减半，分数反映的是最近的负载
+// 分数达到阈值的玩家被标记，回落到阈值一半以下才解除；被标记玩家名下的热点区块进入惩罚档
+// 非线程安全，只在服务器线程上调用
+class LoadAttribution {
+public:
+    static constexpr uint32_t kNoPlayer = 0;
+
+    struct Settings {
+        uint32_t placementWindow = 12000; // 放置记录的有效期（tick）
+        int      nearbyRadius    = 4;     // 区块，切比雪夫距离
+        double   flagMs          = 50.0;  // 与热点报告中的耗时同一口径
+    };
+
+    struct PlayerLoad {
+        std::string name;
+        double      loadMs  = 0.0;
+        uint32_t    chunks  = 0; // 名下的热点区块
+        uint32_t    placed  = 0; // 其中按放置记录归属的
+        bool        flagged = false;
+    };
+
+    struct Counters {
+        uint64_t flags          = 0; // 新标记的次数
+        uint64_t penalizedCalls = 0; // 落在惩罚档的 tickPendingTicks 调用
+        uint64_t unattributed   = 0; // 找不到归属玩家的热点（按周期累计）
+    };
+
+    [[nodiscard]] uint32_t           playerId(std::string const& name);
+    [[nodiscard]] std::string const& nameOf(uint32_t player) const { return mPlayers[player - 1].name; }
+
+    void recordPlacement(uint64_t chunkKey, uint32_t player, uint32_t now) { mPlacements[chunkKey] = {player, now}; }
+
+    // 每个统计周期：beginSnapshot → 对每个在线玩家 addPlayer → attribute
+    void beginSnapshot() { mPositions.clear(); }
+    void addPlayer(uint32_t player, int dimension, int chunkX, int chunkZ) {
+        mPositions.push_back({player, dimension, chunkX, chunkZ});
+    }
+
+    // 重新计算分数和惩罚档，返回本周期被标记或解除标记的玩家（flagged 为变化后的状态）
+    std::vector<PlayerLoad> attribute(std::vector<HotSpotTracker::Entry> const& spots, Settings const& settings, uint32_t now);
+
+    [[nodiscard]] bool hasPenalties() const noexcept { return mPenalized.size() > 0; }
+    [[nodiscard]] bool penalized(uint64_t chunkKey) const noexcept { return mPenalized.find(chunkKey) != nullptr; }
+    void               onPenalized() noexcept { ++mCounters.penalizedCalls; }
+
+    // 按分数从高到低返回有负载的前 n 个玩家
+    [[nodiscard]] std::vector<PlayerLoad> top(size_t n) const;
+
+    [[nodiscard]] size_t          flagged() const noexcept { return mFlagged; }
+    [[nodiscard]] size_t          penalizedChunks() const noexcept { return mPenalized.size(); }
+    [[nodiscard]] size_t          placements() const noexcept { return mPlacements.size(); }
+    [[nodiscard]] Counters const& counters() const noexcept { return mCounters; }
+    Counters                      takeCounters() noexcept;
+
+    // 去掉过期的放置记录并归还容量，在统计任务里调用
+    void expire(uint32_t now, uint32_t window);
+    void clear();
+
+    [[nodiscard]] size_t memoryUsage() const noexcept;
+
+private:
+    struct Placement {
+        uint32_t player = kNoPlayer;
+        uint32_t tick   = 0;
+    };
+
+    struct Position {
+        uint32_t player;
+        int      dimension;
+        int      chunkX;
+        int      chunkZ;
+    };
+
+    struct PlayerState {
+        std::string name;
+        double      loadMs  = 0.0;
+        uint32_t    chunks  = 0;
+        uint32_t    placed  = 0;
+        bool        flagged = false;
+    };
+
+    [[nodiscard]] static PlayerLoad loadOf(PlayerState const& state);
+    [[nodiscard]] uint32_t          nearestPlayer(int dimension, int chunkX, int chunkZ, int radius) const;
+
+    FlatMap<uint64_t, Placement> mPlacements;
+    // FlatMap::find 不是 const
+    mutable FlatMap<uint64_t, uint32_t>       mPenalized;
+    std::vector<Position>                     mPositions;
+    std::vector<PlayerState>                  mPlayers; // 下标 = 玩家编号 - 1
+    std::unordered_map<std::string, uint32_t> mIds;
+    size_t                                    mFlagged = 0;
+    Counters                                  mCounters;
+};
+
+} // namespace pending_tick_optimizer
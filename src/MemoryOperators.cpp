@@ -1,6 +1,63 @@
 // This file will make your mod use LeviLamina's memory operators by default.
 // This improves the memory management of your mod and is recommended to use.
 
+#ifndef PTO_ALLOC_TRACKING
+
 #define LL_MEMORY_OPERATORS
 
 #include "ll/api/memory/MemoryOperators.h" // IWYU pragma: keep
+
+#else
+
+// 调试构建：同样转发到 LeviLamina 的分配器，另外按线程统计分配次数
+#include "AllocTracking.h"
+#include "ll/api/memory/MemoryOperators.h"
+#include <new>
+
+namespace pending_tick_optimizer {
+
+static thread_local uint64_t allocations = 0;
+
+uint64_t threadAllocations() noexcept { return allocations; }
+
+} // namespace pending_tick_optimizer
+
+static void* trackedAlloc(size_t size) {
+    ++pending_tick_optimizer::allocations;
+    return ::ll::memory::getDefaultAllocator().allocate(size);
+}
+
+static void* trackedAllocAligned(size_t size, std::align_val_t align) {
+    ++pending_tick_optimizer::allocations;
+    return ::ll::memory::getDefaultAllocator().allocateAligned(size, static_cast<size_t>(align));
+}
+
+static void trackedRelease(void* ptr) noexcept { ::ll::memory::getDefaultAllocator().release(ptr); }
+
+static void trackedReleaseAligned(void* ptr) noexcept { ::ll::memory::getDefaultAllocator().releaseAligned(ptr); }
+
+// clang-format off
+[[nodiscard]] void* operator new(size_t size) { return trackedAlloc(size); }
+[[nodiscard]] void* operator new[](size_t size) { return trackedAlloc(size); }
+[[nodiscard]] void* operator new(size_t size, std::nothrow_t const&) noexcept { return trackedAlloc(size); }
+[[nodiscard]] void* operator new[](size_t size, std::nothrow_t const&) noexcept { return trackedAlloc(size); }
+[[nodiscard]] void* operator new(size_t size, std::align_val_t align) { return trackedAllocAligned(size, align); }
+[[nodiscard]] void* operator new[](size_t size, std::align_val_t align) { return trackedAllocAligned(size, align); }
+[[nodiscard]] void* operator new(size_t size, std::align_val_t align, std::nothrow_t const&) noexcept { return trackedAllocAligned(size, align); }
+[[nodiscard]] void* operator new[](size_t size, std::align_val_t align, std::nothrow_t const&) noexcept { return trackedAllocAligned(size, align); }
+
+void operator delete(void* ptr) noexcept { trackedRelease(ptr); }
+void operator delete[](void* ptr) noexcept { trackedRelease(ptr); }
+void operator delete(void* ptr, std::nothrow_t const&) noexcept { trackedRelease(ptr); }
+void operator delete[](void* ptr, std::nothrow_t const&) noexcept { trackedRelease(ptr); }
+void operator delete(void* ptr, size_t) noexcept { trackedRelease(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { trackedRelease(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { trackedReleaseAligned(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { trackedReleaseAligned(ptr); }
+void operator delete(void* ptr, std::align_val_t, std::nothrow_t const&) noexcept { trackedReleaseAligned(ptr); }
+void operator delete[](void* ptr, std::align_val_t, std::nothrow_t const&) noexcept { trackedReleaseAligned(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { trackedReleaseAligned(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { trackedReleaseAligned(ptr); }
+// clang-format on
+
+#endif
@@ -0,0 +1,397 @@
+#include "MetricsExporter.h"
+#include <fmt/format.h>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <utility>
+
+namespace pending_tick_optimizer {
+
+// 后台积压超过这么多快照时丢弃最旧的
+static constexpr size_t kMaxQueuedSamples = 16;
+
+void MetricsExporter::start(Settings settings) {
+    if (running()) return;
+    mSettings = std::move(settings);
+    mStopping = false;
+    mThread   = std::thread([this] { run(); });
+}
+
+void MetricsExporter::stop() {
+    if (!running()) return;
+    {
+        std::lock_guard lock(mMutex);
+        mStopping = true;
+    }
+    mWake.notify_one();
+    mThread.join();
+    mQueue.clear();
+}
+
+void MetricsExporter::submit(StatsSample sample) {
+    {
+        std::lock_guard lock(mMutex);
+        if (mQueue.size() >= kMaxQueuedSamples) mQueue.pop_front();
+        mQueue.push_back(std::move(sample));
+    }
+    mWake.notify_one();
+}
+
+void MetricsExporter::run() {
+    std::unique_lock lock(mMutex);
+    while (true) {
+        mWake.wait(lock, [this] { return mStopping || !mQueue.empty(); });
+        // 退出前把已提交的快照写完，关服时最后一个周期不会丢
+        if (mQueue.empty()) return;
+        StatsSample sample = std::move(mQueue.front());
+        mQueue.pop_front();
+        lock.unlock();
+        if (!mSettings.jsonlPath.empty()) writeJsonl(sample);
+        if (!mSettings.prometheusPath.empty()) writePrometheus(sample);
+        lock.lock();
+    }
+}
+
+// ── JSONL ────────────────────────────────────────────────
+
+static nlohmann::json toJson(LatencyHistogram::Summary const& summary) {
+    return {
+        {"count", summary.count},
+        {"p50",   summary.p50  },
+        {"p99",   summary.p99  },
+        {"p999",  summary.p999 },
+        {"max",   summary.max  },
+        {"mean",  summary.mean },
+    };
+}
+
+void MetricsExporter::writeJsonl(StatsSample const& sample) {
+    nlohmann::json line{
+        {"timestamp",     sample.timestampMs  },
+        {"serverTick",    sample.serverTick   },
+        {"globalBudget",  sample.globalBudget },
+        {"trackedQueues", sample.trackedQueues},
+        {"memory",
+         {
+             {"total", sample.memory.total},
+             {"queues", sample.memory.queues},
+             {"scheduling", sample.memory.scheduling},
+             {"analysis", sample.memory.analysis},
+             {"classifiers", sample.memory.classifiers},
+             {"profiling", sample.memory.profiling},
+             {"pools", sample.memory.pools},
+             {"sweptQueues", sample.sweptQueues},
+         }},
+        {"arena",
+         {
+             {"bytes", sample.arenaBytes},
+             {"peak", sample.arenaPeak},
+             {"overflows", sample.arenaOverflows},
+         }},
+        {"tickMs",        toJson(sample.tickMs)},
+        {"pools",
+         {
+             {"dimensionCapped", sample.pools.dimensionCapped},
+             {"areaCapped", sample.pools.areaCapped},
+             {"rolledOver", sample.pools.rolledOver},
+             {"trackedAreas", sample.trackedAreas},
+         }},
+        {"starvation",
+         {
+             {"maxAge", sample.starvation.maxAge},
+             {"reserved", sample.starvation.reserved},
+             {"forced", sample.starvation.forced},
+             {"starving", sample.starvingQueues},
+         }},
+    };
+
+    auto& policies = line["policies"] = nlohmann::json::array();
+    for (auto const& policy : sample.policies) {
+        policies.push_back({
+            {"name",      policy.name     },
+            {"calls",     policy.calls    },
+            {"queued",    policy.queued   },
+            {"capped",    policy.capped   },
+            {"processed", policy.processed},
+        });
+    }
+    auto& dimensions = line["dimensions"] = nlohmann::json::array();
+    for (auto const& dimension : sample.dimensions) {
+        dimensions.push_back({
+            {"dimension", dimension.dimension},
+            {"calls",     dimension.calls    },
+            {"capped",    dimension.capped   },
+            {"processed", dimension.processed},
+        });
+    }
+    if (sample.latencyTiming) {
+        line["latencyUs"] = {
+            {"throttled",   toJson(sample.throttledUs)  },
+            {"passThrough", toJson(sample.passThroughUs)},
+        };
+    }
+    if (sample.adaptive) {
+        line["adaptive"] = {
+            {"budget",     sample.adaptiveState.budget    },
+            {"smoothMspt", sample.adaptiveState.smoothMspt},
+            {"targetMspt", sample.targetMspt              },
+        };
+    }
+    if (sample.timeSliced) {
+        line["timeSlice"] = {
+            {"exhaustedTicks", sample.timeExhaustedTicks},
+            {"cappedCalls",    sample.timeCappedCalls   },
+        };
+    }
+    if (sample.coalesce) line["coalesceMerged"] = sample.merged;
+    if (sample.analysis) {
+        line["analysis"] = {
+            {"captured",        sample.analysisCounters.captured       },
+            {"hits",            sample.analysisCounters.hits           },
+            {"stale",           sample.analysisCounters.stale          },
+            {"dropped",         sample.analysisCounters.dropped        },
+            {"coalesceSkipped", sample.analysisCounters.coalesceSkipped},
+        };
+    }
+    if (sample.burst) {
+        line["burst"] = {
+            {"limited",  sample.burstCounters.limited },
+            {"deferred", sample.burstCounters.deferred},
+            {"smoothed", sample.burstCounters.smoothed},
+            {"queues",   sample.burstQueues           },
+        };
+    }
+    if (sample.portal) {
+        line["portal"] = {
+            {"suppressed",    sample.portalCounters.suppressed   },
+            {"allowed",       sample.portalCounters.allowed      },
+            {"invalidations", sample.portalCounters.invalidations},
+            {"chunks",        sample.portalChunks                },
+        };
+    }
+    if (sample.compaction) {
+        line["compaction"] = {
+            {"queues",    sample.compacted.queues   },
+            {"removed",   sample.compacted.removed  },
+            {"reclaimed", sample.compacted.reclaimed},
+            {"released",  sample.compacted.released },
+        };
+    }
+    if (sample.attribution) {
+        auto players = nlohmann::json::array();
+        for (auto const& player : sample.attributedPlayers) {
+            players.push_back({
+                {"name",    player.name   },
+                {"loadMs",  player.loadMs },
+                {"chunks",  player.chunks },
+                {"placed",  player.placed },
+                {"flagged", player.flagged},
+            });
+        }
+        line["attribution"] = {
+            {"flagged",         sample.flaggedPlayers                     },
+            {"flags",           sample.attributionCounters.flags          },
+            {"unattributed",    sample.attributionCounters.unattributed   },
+            {"penalizedChunks", sample.penalizedChunks                    },
+            {"penalizedCalls",  sample.attributionCounters.penalizedCalls },
+            {"placements",      sample.placements                         },
+            {"players",         std::move(players)                        },
+        };
+    }
+    if (sample.proximity) {
+        line["proximity"] = {
+            {"players",     sample.players    },
+            {"nearCalls",   sample.nearCalls  },
+            {"farCalls",    sample.farCalls   },
+            {"reserveUsed", sample.reserveUsed},
+        };
+    }
+
+    std::error_code ec;
+    if (mSettings.maxJsonlBytes > 0 && std::filesystem::file_size(mSettings.jsonlPath, ec) > mSettings.maxJsonlBytes
+        && !ec) {
+        auto rotated = std::filesystem::path(mSettings.jsonlPath).concat(".1");
+        std::filesystem::rename(mSettings.jsonlPath, rotated, ec);
+    }
+    std::ofstream file(mSettings.jsonlPath, std::ios::app);
+    file << line.dump() << '\n';
+}
+
+// ── Prometheus textfile ──────────────────────────────────
+
+namespace {
+
+std::string escapeLabel(std::string_view value) {
+    std::string result;
+    result.reserve(value.size());
+    for (char c : value) {
+        if (c == '\\' || c == '"') result += '\\';
+        if (c == '\n') {
+            result += "\\n";
+            continue;
+        }
+        result += c;
+    }
+    return result;
+}
+
+class PromWriter {
+public:
+    explicit PromWriter(std::map<std::string, double>& totals) : mTotals(totals) {}
+
+    void family(std::string_view name, std::string_view type, std::string_view help) {
+        mOut += fmt::format("# HELP {} {}\n# TYPE {} {}\n", name, help, name, type);
+    }
+
+    void gauge(std::string_view name, std::string_view labels, double value) { line(name, labels, value); }
+
+    // delta 是本周期增量，输出的是累计值
+    void counter(std::string_view name, std::string_view labels, double delta) {
+        auto& total  = mTotals[fmt::format("{}{{{}}}", name, labels)];
+        total       += delta;
+        line(name, labels, total);
+    }
+
+    // 分位数是本周期的，_count / _sum 按 Prometheus 约定累计
+    void summary(std::string_view name, std::string_view labels, LatencyHistogram::Summary const& summary) {
+        std::string sep = labels.empty() ? "" : ",";
+        line(name, fmt::format("{}{}quantile=\"0.5\"", labels, sep), summary.p50);
+        line(name, fmt::format("{}{}quantile=\"0.99\"", labels, sep), summary.p99);
+        line(name, fmt::format("{}{}quantile=\"0.999\"", labels, sep), summary.p999);
+        counter(fmt::format("{}_count", name), labels, static_cast<double>(summary.count));
+        counter(fmt::format("{}_sum", name), labels, summary.mean * static_cast<double>(summary.count));
+    }
+
+    [[nodiscard]] std::string const& str() const noexcept { return mOut; }
+
+private:
+    void line(std::string_view name, std::string_view labels, double value) {
+        if (labels.empty()) {
+            mOut += fmt::format("{} {}\n", name, value);
+        } else {
+            mOut += fmt::format("{}{{{}}} {}\n", name, labels, value);
+        }
+    }
+
+    std::map<std::string, double>& mTotals;
+    std::string                    mOut;
+};
+
+} // namespace
+
+void MetricsExporter::writePrometheus(StatsSample const& sample) {
+    PromWriter out(mTotals);
+
+    auto policyLabel = [](StatsSample::Policy const& policy) {
+        return fmt::format("policy=\"{}\"", escapeLabel(policy.name));
+    };
+    out.family("pto_policy_calls_total", "counter", "tickPendingTicks calls matched by the policy");
+    for (auto const& policy : sample.policies) out.counter("pto_policy_calls_total", policyLabel(policy), policy.calls);
+    out.family("pto_policy_queued_total", "counter", "Pending ticks queued at call time, summed over calls");
+    for (auto const& policy : sample.policies) out.counter("pto_policy_queued_total", policyLabel(policy), policy.queued);
+    out.family("pto_policy_capped_total", "counter", "Calls that got less than they asked for");
+    for (auto const& policy : sample.policies) out.counter("pto_policy_capped_total", policyLabel(policy), policy.capped);
+    out.family("pto_policy_processed_total", "counter", "Pending ticks dequeued");
+    for (auto const& policy : sample.policies) {
+        out.counter("pto_policy_processed_total", policyLabel(policy), policy.processed);
+    }
+
+    auto dimensionLabel = [](StatsSample::Dimension const& dimension) {
+        return fmt::format("dimension=\"{}\"", dimension.dimension);
+    };
+    out.family("pto_dimension_calls_total", "counter", "Throttled calls per dimension");
+    for (auto const& d : sample.dimensions) out.counter("pto_dimension_calls_total", dimensionLabel(d), d.calls);
+    out.family("pto_dimension_capped_total", "counter", "Capped calls per dimension");
+    for (auto const& d : sample.dimensions) out.counter("pto_dimension_capped_total", dimensionLabel(d), d.capped);
+    out.family("pto_dimension_processed_total", "counter", "Pending ticks dequeued per dimension");
+    for (auto const& d : sample.dimensions) out.counter("pto_dimension_processed_total", dimensionLabel(d), d.processed);
+
+    out.family("pto_tick_milliseconds", "summary", "Level::tick duration");
+    out.summary("pto_tick_milliseconds", "", sample.tickMs);
+    if (sample.latencyTiming) {
+        out.family("pto_pending_ticks_microseconds", "summary", "tickPendingTicks duration");
+        out.summary("pto_pending_ticks_microseconds", "path=\"throttled\"", sample.throttledUs);
+        out.summary("pto_pending_ticks_microseconds", "path=\"pass_through\"", sample.passThroughUs);
+    }
+
+    out.family("pto_global_budget", "gauge", "Global budget for the next tick");
+    out.gauge("pto_global_budget", "", sample.globalBudget);
+    out.family("pto_tracked_queues", "gauge", "Queues with incremental classification state");
+    out.gauge("pto_tracked_queues", "", static_cast<double>(sample.trackedQueues));
+    out.family("pto_memory_bytes", "gauge", "Memory held by the plugin's own tables");
+    out.gauge("pto_memory_bytes", "component=\"queues\"", static_cast<double>(sample.memory.queues));
+    out.gauge("pto_memory_bytes", "component=\"scheduling\"", static_cast<double>(sample.memory.scheduling));
+    out.gauge("pto_memory_bytes", "component=\"analysis\"", static_cast<double>(sample.memory.analysis));
+    out.gauge("pto_memory_bytes", "component=\"classifiers\"", static_cast<double>(sample.memory.classifiers));
+    out.gauge("pto_memory_bytes", "component=\"profiling\"", static_cast<double>(sample.memory.profiling));
+    out.gauge("pto_memory_bytes", "component=\"pools\"", static_cast<double>(sample.memory.pools));
+    out.family("pto_arena_bytes", "gauge", "Per-tick scratch arena capacity");
+    out.gauge("pto_arena_bytes", "", static_cast<double>(sample.arenaBytes));
+    if (sample.allocTracking) {
+        out.family("pto_hot_path_allocations_total", "counter", "Heap allocations made by the plugin's hooks (debug builds)");
+        out.counter("pto_hot_path_allocations_total", "", static_cast<double>(sample.hotPathAllocations));
+    }
+    out.family("pto_pool_capped_total", "counter", "Calls capped by a budget pool");
+    out.counter("pto_pool_capped_total", "level=\"dimension\"", static_cast<double>(sample.pools.dimensionCapped));
+    out.counter("pto_pool_capped_total", "level=\"area\"", static_cast<double>(sample.pools.areaCapped));
+    out.family("pto_starving_queues", "gauge", "Queues currently starving");
+    out.gauge("pto_starving_queues", "", static_cast<double>(sample.starvingQueues));
+    out.family("pto_starvation_forced_total", "counter", "Forced grants for starved queues");
+    out.counter("pto_starvation_forced_total", "", static_cast<double>(sample.starvation.forced));
+    if (sample.analysis) {
+        out.family("pto_analysis_lookups_total", "counter", "Background analysis results used or rejected as stale");
+        out.counter("pto_analysis_lookups_total", "result=\"hit\"", static_cast<double>(sample.analysisCounters.hits));
+        out.counter("pto_analysis_lookups_total", "result=\"stale\"", static_cast<double>(sample.analysisCounters.stale));
+    }
+    if (sample.burst) {
+        out.family("pto_burst_deferred_total", "counter", "Ticks deferred by per-queue token buckets and backlog smoothing");
+        out.counter("pto_burst_deferred_total", "", static_cast<double>(sample.burstCounters.deferred));
+    }
+
+    if (sample.adaptive) {
+        out.family("pto_smoothed_mspt", "gauge", "Smoothed MSPT seen by the adaptive controller");
+        out.gauge("pto_smoothed_mspt", "", sample.adaptiveState.smoothMspt);
+    }
+    if (sample.timeSliced) {
+        out.family("pto_time_capped_calls_total", "counter", "Calls capped by the time slice");
+        out.counter("pto_time_capped_calls_total", "", static_cast<double>(sample.timeCappedCalls));
+    }
+    if (sample.coalesce) {
+        out.family("pto_coalesce_merged_total", "counter", "Duplicate pending ticks merged");
+        out.counter("pto_coalesce_merged_total", "", static_cast<double>(sample.merged));
+    }
+    if (sample.portal) {
+        out.family("pto_portal_suppressed_total", "counter", "Portal ticks not scheduled because the neighbourhood was unchanged");
+        out.counter("pto_portal_suppressed_total", "", static_cast<double>(sample.portalCounters.suppressed));
+    }
+    if (sample.compaction) {
+        out.family("pto_compaction_reclaimed_bytes_total", "counter", "Bytes of tombstones removed from heaps");
+        out.counter("pto_compaction_reclaimed_bytes_total", "", static_cast<double>(sample.compacted.reclaimed));
+    }
+    if (sample.attribution) {
+        out.family("pto_flagged_players", "gauge", "Players whose attributed hot-spot load is over the flag threshold");
+        out.gauge("pto_flagged_players", "", static_cast<double>(sample.flaggedPlayers));
+        out.family("pto_attribution_flags_total", "counter", "Times a player was flagged for pending tick load");
+        out.counter("pto_attribution_flags_total", "", static_cast<double>(sample.attributionCounters.flags));
+        out.family("pto_penalized_calls_total", "counter", "Calls in chunks moved to the penalty tier");
+        out.counter("pto_penalized_calls_total", "", static_cast<double>(sample.attributionCounters.penalizedCalls));
+        out.family("pto_attributed_load_ms", "gauge", "Hot-spot load attributed to the top players");
+        for (auto const& player : sample.attributedPlayers) {
+            out.gauge("pto_attributed_load_ms", fmt::format("player=\"{}\"", escapeLabel(player.name)), player.loadMs);
+        }
+    }
+    if (sample.proximity) {
+        out.family("pto_players", "gauge", "Players in the proximity snapshot");
+        out.gauge("pto_players", "", static_cast<double>(sample.players));
+    }
+
+    // 先写临时文件再替换，抓取方不会读到半个文件
+    auto          temp = std::filesystem::path(mSettings.prometheusPath).concat(".tmp");
+    std::ofstream file(temp);
+    file << out.str();
+    file.close();
+    if (!file) return;
+    std::error_code ec;
+    std::filesystem::rename(temp, mSettings.prometheusPath, ec);
+}
+
+} // namespace pending_tick_optimizer
@@ -0,0 +1,54 @@
+#pragma once
+#include "StatsSample.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace pending_tick_optimizer {
+
+// 把统计快照导出成时间序列：追加 JSONL，并整体重写一份 Prometheus textfile
+// （交给 node_exporter 的 textfile collector 抓取）
+// 服务器线程只负责把快照移进队列，序列化和文件 IO 都在后台线程
+class MetricsExporter {
+public:
+    struct Settings {
+        std::filesystem::path jsonlPath;      // 为空则不写 JSONL
+        std::filesystem::path prometheusPath; // 为空则不写 textfile
+        uint64_t              maxJsonlBytes  = 0; // 超过后轮转为 .1，0 不限
+    };
+
+    MetricsExporter() = default;
+    MetricsExporter(MetricsExporter const&)            = delete;
+    MetricsExporter& operator=(MetricsExporter const&) = delete;
+    ~MetricsExporter() { stop(); }
+
+    void start(Settings settings);
+    void stop();
+
+    // 后台来不及处理时丢弃最旧的快照，不阻塞调用方
+    void submit(StatsSample sample);
+
+    [[nodiscard]] bool running() const noexcept { return mThread.joinable(); }
+
+private:
+    void run();
+    void writeJsonl(StatsSample const& sample);
+    void writePrometheus(StatsSample const& sample);
+
+    Settings                mSettings;
+    std::thread             mThread;
+    std::mutex              mMutex;
+    std::condition_variable mWake;
+    std::deque<StatsSample> mQueue;
+    bool                    mStopping = false;
+
+    // 以下只在后台线程上访问：快照里是本周期增量，Prometheus 计数器要的是累计值
+    std::map<std::string, double> mTotals;
+};
+
+} // namespace pending_tick_optimizer
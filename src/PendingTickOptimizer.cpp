@@ -1,42 +1,312 @@
 #include "PendingTickOptimizer.h"
+#include "AdaptiveController.h"
+#include "AllocTracking.h"
+#include "Benchmark.h"
+#include "BlockClassifier.h"
+#include "BudgetPools.h"
+#include "BurstLimiter.h"
+#include "ChunkKey.h"
+#include "Command.h"
+#include "Clock.h"
+#include "CostModel.h"
+#include "HotSpotTracker.h"
+#include "LatencyHistogram.h"
+#include "LoadAttribution.h"
+#include "MetricsExporter.h"
+#include "PortalSuppressor.h"
+#include "ProximityTiers.h"
+#include "QueueAnalyzer.h"
+#include "QueueTracker.h"
+#include "StarvationScheduler.h"
+#include "TickArena.h"
+#include "ThreadSlots.h"
+#include "TickCoalescer.h"
+#include "TombstoneCompactor.h"
+#include "TraceRecorder.h"
+#include "TypeColumns.h"
+#include "WorldProfile.h"
 #include "ll/api/memory/Hook.h"
 #include "ll/api/mod/RegisterHelper.h"
 #include "ll/api/coro/CoroTask.h"
+#include "ll/api/event/EventBus.h"
+#include "ll/api/event/player/PlayerPlaceBlockEvent.h"
+#include "ll/api/service/Bedrock.h"
 #include "ll/api/thread/ServerThreadExecutor.h"
 #include "ll/api/io/Logger.h"
 #include "ll/api/io/LoggerRegistry.h"
+#include "mc/world/actor/player/Player.h"
 #include "mc/world/level/BlockSource.h"
 #include "mc/world/level/Level.h"
 #include "mc/world/level/BlockTickingQueue.h"
 #include "mc/world/level/Tick.h"
+#include "mc/world/level/block/Block.h"
+#include "mc/world/level/chunk/LevelChunk.h"
+#include "mc/world/level/dimension/Dimension.h"
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <array>
 #include <filesystem>
+#include <fstream>
+#include <functional>
 #include <chrono>
+#include <cmath>
 #include <atomic>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
 
 namespace pending_tick_optimizer {
 
-static Config                          config;
+static Config                          config; // 编辑副本：加载、保存和命令修改都作用在这里，再经 publishConfig 发布
 static std::shared_ptr<ll::io::Logger> log;
 static std::atomic<bool>               pluginEnabled{false};
 static std::atomic<bool>               hookInstalled{false};
+static BlockClassifier                 classifier;
+static BlockClassifier                 coalesceClassifier; // 只有一个集合：可合并的幂等方块
+static BlockClassifier                 portalClassifier;   // 只有一个集合：计划刻只做框架校验的传送门方块
+static PortalSuppressor                portals;
+static TickCoalescer                   coalescer;
+static TombstoneCompactor              compactor;
+static CostModel                       costModel;
+static ProximityTiers                  proximity;
+static QueueTracker                    queueTracker;
+static QueueAnalyzer                   analyzer;
+static TypeIdTable                     typeIds;   // 全量扫描用的类型 id
+static TickArena                       tickArena; // 服务器线程上每 tick 的临时缓冲，Level::tick 开始时 reset
+static BudgetPools                     budgetPools;
+static StarvationScheduler             starvation;
+static BurstLimiter                    burst;
+static AdaptiveController              adaptive;
+static LatencyHistogram                throttledLatency;   // 命中策略的队列，单位为 TSC 计数
+static LatencyHistogram                passThroughLatency; // 放行的队列，单位为 TSC 计数
+static LatencyHistogram                tickLatency;        // Level::tick 整体耗时，单位为纳秒
+static MetricsExporter                 metrics;
+static TraceRecorder                   tracer;
+static HotSpotTracker                  hotSpots;
+static LoadAttribution                 attribution;
+static ll::event::ListenerPtr          placeListener; // 负载归属的放置记录
+static thread_local int                profileCountdown = 0;
+static thread_local bool               onServerThread = false;
+static uint32_t                        serverTick     = 0;
+static uint64_t                        sweptQueues    = 0;
 
-static std::atomic<int>      gTickBudgetRemaining{0};
-static std::atomic<uint64_t> totalCallCount{0};
-static std::atomic<uint64_t> totalQueued{0};
-static std::atomic<uint64_t> totalCapped{0};
+// 正在 tickPendingTicks 里的队列，以及期间它自己新增的刻数，用来推算实际出队数
+static thread_local void const* drainingQueue = nullptr;
+static thread_local size_t      drainAdds     = 0;
+
+static size_t drainedCount(size_t sizeBefore, size_t sizeAfter) {
+    size_t total = sizeBefore + drainAdds;
+    return total - std::min(sizeAfter, total);
+}
+
+// ── 热路径分配计数 ────────────────────────────────────────
+// 只在 PTO_ALLOC_TRACKING 构建里有数。最外层钩子进入时记下当前线程的分配数，退出时累加差值；
+// Level::tick 调用原函数期间暂停，那段时间里的钩子各自计数，嵌套的钩子算在外层里
+
+struct AllocTally {
+    uint64_t ticks           = 0;
+    uint64_t allocatingTicks = 0; // 热路径上有过分配的 tick
+    uint64_t allocations     = 0;
+};
+
+static thread_local int allocDepth      = 0;
+static uint64_t         tickAllocations = 0; // 当前 tick 到目前为止的分配次数
+static AllocTally       allocTally;
+
+class AllocScope {
+public:
+    AllocScope() { resume(); }
+    ~AllocScope() { pause(); }
+    AllocScope(AllocScope const&)            = delete;
+    AllocScope& operator=(AllocScope const&) = delete;
+
+    void resume() {
+        mActive = kAllocTracking && onServerThread;
+        if (mActive && allocDepth++ == 0) mBegin = threadAllocations();
+    }
+
+    void pause() {
+        if (!mActive) return;
+        mActive = false;
+        if (--allocDepth == 0) tickAllocations += threadAllocations() - mBegin;
+    }
+
+private:
+    bool     mActive = false;
+    uint64_t mBegin  = 0;
+};
+
+// 每个 tick 开始时结算上一 tick
+static void settleTickAllocations() {
+    if constexpr (kAllocTracking) {
+        ++allocTally.ticks;
+        if (tickAllocations > 0) {
+            ++allocTally.allocatingTicks;
+            allocTally.allocations += tickAllocations;
+        }
+        tickAllocations = 0;
+    }
+}
+
+struct DrainResult {
+    bool     result     = false; // 原函数的返回值
+    int      ran        = 0;     // 实际出队数，不超过 limit
+    size_t   sizeBefore = 0;
+    size_t   remaining  = 0;     // 返回后队列里剩下的条目，含未到期的刻和墓碑
+    size_t   adds       = 0;     // 期间这个队列自己新增的刻数
+    uint64_t elapsed    = 0;     // TSC 计数
+};
+
+// 部分出队：原函数数到 max 就停，把 max 设成 limit 即可精确限量，instaTick 由调用方原样透传
+// 出队无法逐条观察，按大小变化加上期间自己新增的刻数推算
+template <class Origin>
+static DrainResult drainPartial(BlockTickingQueue const& queue, int limit, Origin&& origin) {
+    DrainResult drain{.sizeBefore = queue.mNextTickQueue.mC.size()};
+    uint64_t    begin = readTsc();
+    drainingQueue     = &queue;
+    drainAdds         = 0;
+    drain.result      = origin(limit);
+    drainingQueue     = nullptr;
+    drain.elapsed     = readTsc() - begin;
+    drain.remaining   = queue.mNextTickQueue.mC.size();
+    drain.adds        = drainAdds;
+    // 弹出的墓碑也会让大小变小，但不占 max，推算值不能超过 limit
+    auto ran  = drainedCount(drain.sizeBefore, drain.remaining);
+    drain.ran = static_cast<int>(std::min(ran, static_cast<size_t>(std::max(0, limit))));
+    return drain;
+}
+
+// 其它线程上析构的队列先登记，下一 tick 开始时在服务器线程统一驱逐
+static std::mutex               deferredEvictMutex;
+static std::vector<void const*> deferredEvictions;
+
+static std::atomic<int> gTickBudgetRemaining{0};
+static std::atomic<int> gNearBudgetRemaining{0}; // 本 tick 只给附近区块用的预留
+
+struct ProximityCounters {
+    uint64_t nearCalls   = 0;
+    uint64_t farCalls    = 0;
+    uint64_t reserveUsed = 0;
+};
+static ProximityCounters proximityCounters; // 只在服务器线程上读写
+
+// time 模式：每 tick 的处理时间切片，以及各策略单个计划刻的平滑耗时，用来把切片折算成条数
+static bool                             timeSliced = false;
+static std::atomic<int64_t>             gTickTimeRemainingNs{0};
+static std::array<double, kMaxPolicies> policyNsPerTick{}; // 只在服务器线程上读写
+static std::atomic<uint64_t>            timeCappedCalls{0};
+static uint64_t                         timeExhaustedTicks = 0;
+static ThreadSlots      threadSlots;
+static uint64_t         leaseReturned = 0; // 只在服务器线程上累加
+
+// 从配置整理出的生效策略，下标与分类掩码的位一一对应
+struct ActivePolicy {
+    std::string name;
+    int         budgetPerCall;
+    int         globalBudgetPerTick;
+
+    std::vector<uint16_t> typeIds = {}; // 方块列表对应的类型 id，全量扫描时做成员计数
+};
+
+// 按维度汇总的限流计数，自定义维度与 BudgetPools 一样折叠进最后一个槽
+struct DimensionTally {
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> capped{0};
+    std::atomic<uint64_t> processed{0};
+};
+
+static std::array<DimensionTally, BudgetPools::kMaxDimensions> dimensionTallies;
+
+static DimensionTally& dimensionTally(int dimension) {
+    return dimensionTallies
+        [dimension >= 0 && dimension < BudgetPools::kMaxDimensions ? dimension : BudgetPools::kMaxDimensions - 1];
+}
+
+static std::vector<ActivePolicy>                  activePolicies;
+static std::array<std::atomic<int>, kMaxPolicies> policyBudgetRemaining{};
+
+// ── 配置快照 ──────────────────────────────────────────────
+// RCU：读者一次 acquire load 拿到不可变快照，整个钩子调用期间只用这一份；
+// 发布只在服务器线程上进行，旧快照留够宽限期后再释放，其它线程上正在进行的调用不会读到悬空指针
+
+static constexpr uint32_t kConfigGraceTicks = 200;
+
+static Config const                    defaultConfig{};
+static std::atomic<Config const*>      liveConfig{&defaultConfig};
+static std::unique_ptr<Config const>   ownedConfig;
+static std::filesystem::file_time_type configWriteTime{};
+// 退役的快照及其退役时的 tick
+static std::vector<std::pair<uint32_t, std::unique_ptr<Config const>>> retiredConfigs;
+
+Config const& currentConfig() { return *liveConfig.load(std::memory_order_acquire); }
+
+static void reclaimRetiredConfigs(uint32_t now) {
+    std::erase_if(retiredConfigs, [now](auto const& retired) { return now - retired.first >= kConfigGraceTicks; });
+}
 
 // ── 工具函数 ──────────────────────────────────────────────
 
 Config& getConfig() { return config; }
 
+static std::filesystem::path configPath() {
+    return PluginImpl::getInstance().getSelf().getConfigDir() / "config.json";
+}
+
+// 版本号缺失或不符时由 loadConfig 调用，改的是 data：loadConfig 随后把它反序列化进 cfg；返回 false 表示读取失败
+// 是否写回由 loadConfig 自己决定，这里另外记一笔，readConfig 保证迁移过的文件一定写回，下次不再重复迁移
+static bool configMigrated = false;
+
+static bool migrateConfig(Config& cfg, nlohmann::ordered_json& data) {
+    int  from        = data.contains("version") && data["version"].is_number_integer() ? data["version"].get<int>() : 0;
+    bool hadPolicies = data.contains("policies");
+    std::optional<nlohmann::ordered_json> throttledBlocks;
+    // v1：限流的方块集是顶层的 throttledBlocks，对应现在第一个策略的 blocks
+    if (from < 2 && data.contains("throttledBlocks")) {
+        if (data["throttledBlocks"].is_array()) {
+            throttledBlocks.emplace(nlohmann::ordered_json::array());
+            for (auto const& block : data["throttledBlocks"]) {
+                if (block.is_string()) throttledBlocks->push_back(block);
+            }
+        }
+        data.erase("throttledBlocks");
+    }
+    // 默认更新器把当前结构的默认值合并进 data，之后 policies 一定存在，所以要先记下原文件里有没有
+    if (!ll::config::defaultConfigUpdater(cfg, data)) return false;
+    if (throttledBlocks && !hadPolicies) {
+        auto& policies = data["policies"];
+        if (policies.is_array() && !policies.empty()) policies[0]["blocks"] = std::move(*throttledBlocks);
+    }
+    configMigrated = true;
+    logger().info("Config migrated from version {} to {}", from, cfg.version);
+    return true;
+}
+
+static bool readConfig(Config& cfg, std::filesystem::path const& path) {
+    configMigrated = false;
+    if (!ll::config::loadConfig<Config, nlohmann::ordered_json>(cfg, path, migrateConfig)) return false;
+    if (configMigrated && !ll::config::saveConfig(cfg, path)) {
+        logger().warn("Failed to write the migrated config back to {}", path.string());
+    }
+    return true;
+}
+
 bool loadConfig() {
-    auto path = PluginImpl::getInstance().getSelf().getConfigDir() / "config.json";
-    return ll::config::loadConfig(config, path);
+    return readConfig(config, configPath());
 }
 
 bool saveConfig() {
-    auto path = PluginImpl::getInstance().getSelf().getConfigDir() / "config.json";
-    return ll::config::saveConfig(config, path);
+    auto path = configPath();
+    bool ok   = ll::config::saveConfig(config, path);
+    // 自己写出的文件不算外部修改，不触发重载
+    std::error_code ec;
+    configWriteTime = std::filesystem::last_write_time(path, ec);
+    return ok;
+}
+
+static std::filesystem::path costModelPath() {
+    return PluginImpl::getInstance().getSelf().getConfigDir() / "cost_model.json";
 }
 
 ll::io::Logger& logger() {
@@ -46,23 +316,612 @@ ll::io::Logger& logger() {
     return *log;
 }
 
-// ── 工具函数：检查队列是否全是 portal tick ────────────────
+// ── 工具函数：策略与队列分类 ──────────────────────────────
+
+// 计数只是不够精确（大小仍一致）时，两次全量扫描之间至少间隔的 tick 数
+static constexpr uint32_t kRescanInterval = 20;
+
+// 上次应用时的输入；publishConfig 每次都会调用，输入没变就保留学到的耗时和队列计数
+static std::string                           appliedBudgetMode;
+static std::vector<std::string>              appliedPolicyNames;
+static std::vector<std::vector<std::string>> appliedPolicyBlocks;
+static std::vector<PolicyMatch>              appliedPolicyModes;
+static std::vector<std::string>              appliedCoalesceBlocks;
+static std::vector<std::string>              appliedPortalBlocks;
+static bool                                  policiesApplied = false;
+
+static void applyBudgetMode(Config const& cfg) {
+    timeSliced = cfg.budgetMode == "time";
+    if (cfg.budgetMode != appliedBudgetMode) {
+        if (!timeSliced && cfg.budgetMode != "count") {
+            logger().warn("Unknown budget mode '{}', falling back to 'count'", cfg.budgetMode);
+        }
+        policyNsPerTick.fill(0.0);
+        appliedBudgetMode = cfg.budgetMode;
+    }
+    if (!cfg.burstLimiting && !cfg.backlogSmoothing) burst.clear();
+}
+
+static void applyProximity(Config const& cfg) {
+    std::vector<ProximityTiers::Area> areas;
+    for (auto const& area : cfg.protectedAreas) {
+        areas.push_back({
+            .dimension = area.dimension,
+            .minChunkX = std::min(area.minX, area.maxX) >> 4,
+            .minChunkZ = std::min(area.minZ, area.maxZ) >> 4,
+            .maxChunkX = std::max(area.minX, area.maxX) >> 4,
+            .maxChunkZ = std::max(area.minZ, area.maxZ) >> 4,
+        });
+    }
+    proximity.setAreas(std::move(areas));
+    proximity.setRadius(cfg.nearChunkRadius);
+}
+
+static void applyPolicies(Config const& cfg) {
+    activePolicies.clear();
+    std::vector<std::string>              names;
+    std::vector<std::vector<std::string>> blocks;
+    std::vector<PolicyMatch>              modes;
+    for (auto const& policy : cfg.policies) {
+        if (!policy.enabled) continue;
+        if (activePolicies.size() >= kMaxPolicies) {
+            logger().warn("At most {} policies can be enabled, ignoring '{}'", kMaxPolicies, policy.name);
+            continue;
+        }
+        auto match = PolicyMatch::Only;
+        if (policy.match == "any") {
+            match = PolicyMatch::Any;
+        } else if (policy.match != "only") {
+            logger().warn("Unknown match '{}' in policy '{}', using 'only'", policy.match, policy.name);
+        }
+        activePolicies.push_back({
+            .name                = policy.name,
+            .budgetPerCall       = policy.budgetPerCall > 0 ? policy.budgetPerCall : cfg.budgetPerTick,
+            .globalBudgetPerTick = policy.globalBudgetPerTick,
+        });
+        names.push_back(policy.name);
+        blocks.push_back(policy.blocks);
+        modes.push_back(match);
+    }
+
+    // 策略的下标对应分类掩码的位、耗时估计和队列计数，策略表没变时这些都不用重建
+    bool policiesChanged = !policiesApplied || names != appliedPolicyNames || blocks != appliedPolicyBlocks
+                        || modes != appliedPolicyModes;
+    bool coalesceChanged = !policiesApplied || cfg.coalesceBlocks != appliedCoalesceBlocks;
+    if (policiesChanged) {
+        classifier.setPolicies(blocks);
+        typeIds.clear();
+        queueTracker.setPolicies(modes);
+        policyNsPerTick.fill(0.0);
+    }
+    // 类型编号每次都重新查；表没清空时 idFor 原样返回已有的编号
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        auto& ids = activePolicies[i].typeIds;
+        for (auto const& name : blocks[i]) {
+            uint16_t id = typeIds.idFor(name);
+            if (id != TypeIdTable::kOverflow && std::find(ids.begin(), ids.end(), id) == ids.end()) ids.push_back(id);
+        }
+    }
+    if (coalesceChanged) coalesceClassifier.setPolicies({cfg.coalesceBlocks});
+    if (policiesChanged || coalesceChanged) analyzer.setPolicies(blocks, cfg.coalesceBlocks);
+    if (!policiesApplied || cfg.portalBlocks != appliedPortalBlocks) portalClassifier.setPolicies({cfg.portalBlocks});
+    portals.setRadius(cfg.portalWatchRadius);
+    // 关闭期间观察不到方块变化，之前的校验结果不能再用
+    if (!cfg.portalSuppression) portals.clear();
+
+    appliedPolicyNames    = std::move(names);
+    appliedPolicyBlocks   = std::move(blocks);
+    appliedPolicyModes    = std::move(modes);
+    appliedCoalesceBlocks = cfg.coalesceBlocks;
+    appliedPortalBlocks   = cfg.portalBlocks;
+    policiesApplied       = true;
+}
+
+// 按配置启停后台预分析线程
+static void syncQueueAnalyzer(Config const& cfg) {
+    if (cfg.backgroundAnalysis == analyzer.running()) return;
+    if (!cfg.backgroundAnalysis) {
+        analyzer.stop();
+        return;
+    }
+    analyzer.start([](void const* block) -> std::string const& {
+        return static_cast<Block const*>(block)->getTypeName();
+    });
+}
+
+// 按配置启停 trace 录制，每次开始都写一个新文件
+static void syncTraceRecorder(Config const& cfg) {
+    if (!cfg.traceEnabled) {
+        if (!tracer.running()) return;
+        tracer.stop();
+        logger().info("Trace stopped | written: {} | dropped: {}", tracer.written(), tracer.dropped());
+        return;
+    }
+    if (tracer.running()) return;
+    auto now  = std::chrono::system_clock::now().time_since_epoch();
+    auto ms   = std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+    auto path = PluginImpl::getInstance().getSelf().getDataDir() / "traces" / fmt::format("trace-{}.ptt", ms);
+    if (!tracer.start({.path = path, .capacity = static_cast<size_t>(std::max(1024, cfg.traceBufferSize))}, ms)) {
+        logger().warn("Failed to open trace file {}", path.string());
+        return;
+    }
+    logger().info("Recording trace to {}", path.string());
+}
+
+// 按配置挂上或摘下放置监听；放置事件在服务器线程上派发，只记区块和玩家，归属留到统计周期
+static void syncPlaceListener(Config const& cfg) {
+    auto& bus = ll::event::EventBus::getInstance();
+    if (cfg.attributionEnabled && !placeListener) {
+        placeListener = bus.emplaceListener<ll::event::player::PlayerPlacedBlockEvent>(
+            [](ll::event::player::PlayerPlacedBlockEvent& event) {
+                auto& player = event.self();
+                auto  pos    = event.pos();
+                attribution.recordPlacement(
+                    packChunkKey(player.getDimensionId().id, pos.x >> 4, pos.z >> 4),
+                    attribution.playerId(player.getRealName()),
+                    serverTick
+                );
+            }
+        );
+    } else if (!cfg.attributionEnabled && placeListener) {
+        bus.removeListener(placeListener);
+        placeListener = nullptr;
+        attribution.clear();
+    }
+}
+
+// 把编辑副本发布成新快照，并重建依赖配置的派生状态
+// 派生状态只在服务器线程上使用，所以发布也只在服务器线程上（或钩子安装前的 load 阶段）进行
+void publishConfig() {
+    auto next = std::make_unique<Config const>(config);
+    applyBudgetMode(*next);
+    applyPolicies(*next);
+    applyProximity(*next);
+    if (pluginEnabled.load(std::memory_order_relaxed)) {
+        syncTraceRecorder(*next);
+        syncQueueAnalyzer(*next);
+        syncPlaceListener(*next);
+    }
+    Config const* previous = liveConfig.exchange(next.get(), std::memory_order_acq_rel);
+    if (previous->profilerCapacity != next->profilerCapacity || !ownedConfig) {
+        hotSpots.setCapacity(static_cast<size_t>(std::max(1, next->profilerCapacity)));
+    }
+    if (ownedConfig) retiredConfigs.emplace_back(serverTick, std::move(ownedConfig));
+    ownedConfig = std::move(next);
+}
+
+bool reloadConfig() {
+    auto   path = configPath();
+    Config next;
+    if (!readConfig(next, path)) {
+        logger().warn("Failed to reload config, keeping the current one");
+        return false;
+    }
+    std::error_code ec;
+    configWriteTime = std::filesystem::last_write_time(path, ec);
+    config          = std::move(next);
+    publishConfig();
+    logger().info("Config reloaded");
+    return true;
+}
+
+// 配置文件的修改时间变了就重载，自己保存的不算
+static void watchConfigFile() {
+    std::error_code ec;
+    auto            writeTime = std::filesystem::last_write_time(configPath(), ec);
+    if (ec || writeTime == configWriteTime) return;
+    configWriteTime = writeTime;
+    reloadConfig();
+}
+
+static uint32_t policyMaskOf(Block const* block) {
+    return classifier.classify(block, [block]() -> std::string const& { return block->getTypeName(); });
+}
+
+static QueueAnalyzer::Result const* analysisOf(Config const& cfg, BlockTickingQueue const& queue) {
+    if (!analyzer.running()) return nullptr;
+    auto maxStale = static_cast<uint32_t>(std::max(1, cfg.analysisMaxStaleTicks));
+    return analyzer.lookup(&queue, queue.mNextTickQueue.mC.size(), serverTick, maxStale);
+}
+
+// 返回命中的策略下标，-1 放行
+// 优先使用增量计数，计数不可信时先找后台分析的结果，都没有才全量扫描一次并重新同步
+static int classifyQueue(Config const& cfg, BlockTickingQueue const& queue) {
+    auto const& ticks = queue.mNextTickQueue.mC;
+    if (auto* state = queueTracker.find(&queue)) {
+        state->lastSeen = serverTick;
+        int policy      = queueTracker.decide(*state, ticks.size());
+        if (policy != QueueTracker::kUnknown) return policy;
+        if (state->knownSize == ticks.size() && serverTick - state->scanStamp < kRescanInterval) {
+            return state->verdict;
+        }
+    }
+    if (auto const* result = analysisOf(cfg, queue)) {
+        auto& state = queueTracker.adopt(&queue, result->live, result->members, ticks.size(), result->tick);
+        if (cfg.compactionEnabled) compactor.observe(&queue, result->dead);
+        analyzer.discard(&queue);
+        return state.verdict;
+    }
+    // 一遍收集类型 id，再按策略做向量化的成员计数
+    auto columns = TypeColumns::gather(ticks, tickArena, [](Block const* block) {
+        return typeIds.idOf(block, [block]() -> std::string const& { return block->getTypeName(); });
+    });
+    std::array<uint32_t, kMaxPolicies> members{};
+    for (size_t i = 0; i < activePolicies.size(); ++i) {
+        members[i] = static_cast<uint32_t>(columns.count(activePolicies[i].typeIds));
+    }
+    auto& state = queueTracker.adopt(&queue, static_cast<uint32_t>(columns.live), members, ticks.size(), serverTick);
+    if (cfg.compactionEnabled) compactor.observe(&queue, columns.dead);
+    return state.verdict;
+}
 
-static bool isPortalOnlyQueue(BlockTickingQueue::TickDataSet const& queue) {
-    bool hasPortal = false;
-    for (auto const& blockTick : queue.mC) {
-        if (blockTick.mIsRemoved) continue;
-        if (!blockTick.mData.mBlock) continue;
-        auto name = blockTick.mData.mBlock->getTypeName();
-        if (name == "minecraft:portal" ||
-            name == "minecraft:end_portal" ||
-            name == "minecraft:end_gateway") {
-            hasPortal = true;
+// 所有按队列记录的状态都在这里统一驱逐
+static void evictQueueState(void const* queue) {
+    queueTracker.evict(queue);
+    analyzer.evict(queue);
+    // 卸载的饥饿队列不会再来认领，它的预留当场还给全局预算
+    if (int reserved = starvation.evict(queue); reserved > 0) {
+        gTickBudgetRemaining.fetch_add(reserved, std::memory_order_relaxed);
+    }
+    burst.evict(queue);
+    coalescer.evict(queue);
+    compactor.evict(queue);
+    portals.evict(queue);
+    tracer.evict(queue);
+}
+
+// 合并重复计划刻，被打墓碑的刻同步从增量计数里扣掉
+static void coalesceQueue(Config const& cfg, BlockTickingQueue& queue) {
+    auto& ticks = queue.mNextTickQueue.mC;
+    if (!coalescer.due(
+            &queue,
+            ticks.size(),
+            serverTick,
+            {
+                .minQueueSize  = static_cast<uint32_t>(std::max(0, cfg.coalesceMinQueue)),
+                .intervalTicks = static_cast<uint32_t>(std::max(1, cfg.coalesceInterval)),
+            }
+        )) {
+        return;
+    }
+    // 后台确认没有重复刻就不必扫描
+    if (auto const* result = analysisOf(cfg, queue); result && result->duplicates == 0) {
+        analyzer.onCoalesceSkipped();
+        return;
+    }
+    bool   tracked = queueTracker.find(&queue) != nullptr;
+    size_t merged  = coalescer.coalesce(
+        ticks,
+        [](Block const* block) {
+            return coalesceClassifier.classify(block, [block]() -> std::string const& {
+                return block->getTypeName();
+            }) != 0;
+        },
+        [&queue, tracked](Block const* block) {
+            if (tracked) queueTracker.onRemove(&queue, policyMaskOf(block));
+        }
+    );
+    if (merged == 0) return;
+    // 打了墓碑之后后台结果里的存活计数不再准确
+    analyzer.invalidate(&queue);
+    if (cfg.compactionEnabled) compactor.onTombstoned(&queue, merged);
+}
+
+// 长期没被 tick 的队列（析构没被观察到的，或所在区块已不再模拟的）连同各模块的状态一起清掉，
+// 再让按队列记录的表归还驱逐后空出的容量；每 tick 清空重用的临时表（合并扫描的 mFirst、
+// 后台预分析的拷贝与结果表）不在此列，它们停在高水位，稳态 tick 不必重新分配；在统计任务里调用，不在热路径上
+static constexpr uint32_t kIdleQueueTicks = 6000;
+static constexpr size_t   kSweepBatch     = 4096;
+
+static void sweepIdleState() {
+    static std::vector<void const*> idle(kSweepBatch);
+    size_t count = queueTracker.collectIdle(serverTick, kIdleQueueTicks, idle.data(), idle.size());
+    for (size_t i = 0; i < count; ++i) evictQueueState(idle[i]);
+    sweptQueues += count;
+
+    queueTracker.shrink();
+    starvation.shrink();
+    burst.shrink();
+    coalescer.shrink();
+    compactor.shrink();
+    portals.shrink();
+    tracer.shrink();
+    budgetPools.sweep();
+}
+
+// 出队后判断下一 tick 是否还要全量扫描或合并扫描，要的话把元数据拷给后台
+static void captureForAnalysis(Config const& cfg, BlockTickingQueue const& queue, size_t remaining) {
+    if (remaining < static_cast<size_t>(std::max(1, cfg.analysisMinQueue))) return;
+    bool needed = false;
+    if (auto* state = queueTracker.find(&queue)) {
+        needed = queueTracker.decide(*state, remaining) == QueueTracker::kUnknown
+              && !(state->knownSize == remaining && serverTick + 1 - state->scanStamp < kRescanInterval);
+    } else {
+        needed = true;
+    }
+    if (!needed && cfg.coalesceEnabled) {
+        needed = coalescer.wouldRun(
+            &queue,
+            remaining,
+            serverTick + 1,
+            {
+                .minQueueSize  = static_cast<uint32_t>(std::max(0, cfg.coalesceMinQueue)),
+                .intervalTicks = static_cast<uint32_t>(std::max(1, cfg.coalesceInterval)),
+            }
+        );
+    }
+    if (needed) analyzer.capture(&queue, queue.mNextTickQueue.mC, serverTick);
+}
+
+// 墓碑过多的队列去掉墓碑重建堆，排序与游戏一致：tickID 小的先出，其次 priorityOffset 小的先出
+// 压缩后重建堆用的比较器，必须与游戏自己的完全一致，否则出队顺序会变、同刻内的先后被打乱
+// 反编译头文件中 TickDataSet 是 MovePriorityQueue<BlockTick, std::greater<BlockTick>>，
+// BlockTick::operator> 转发给 TickNextTickData::operator>：先比 mTick，相同再比 mPriorityOffset
+// 头文件导出了 operator> 时直接用 std::greater，调用的就是游戏本体的实现；没有导出时按上面的定义复刻，
+// 升级游戏版本后如果这两个函数的反编译结果变了，这里要跟着改
+struct GameTickOrder {
+    template <class T>
+    bool operator()(T const& a, T const& b) const {
+        if constexpr (requires { a > b; }) {
+            return std::greater<T>{}(a, b);
         } else {
-            return false; // 有非 portal 方块，放行
+            if (a.mData.mTick.tickID != b.mData.mTick.tickID) return a.mData.mTick.tickID > b.mData.mTick.tickID;
+            return a.mData.mPriorityOffset > b.mData.mPriorityOffset;
         }
     }
-    return hasPortal;
+};
+
+static void compactQueue(BlockTickingQueue& queue) {
+    auto& ticks = queue.mNextTickQueue.mC;
+    if (!compactor.due(&queue, ticks.size())) return;
+    size_t   sizeBefore = ticks.size();
+    uint64_t begin      = readTsc();
+    compactor.compact(&queue, ticks, GameTickOrder{});
+    compactor.charge(static_cast<uint64_t>(tscToNs(readTsc() - begin)));
+    queueTracker.onCompacted(&queue, sizeBefore, ticks.size());
+}
+
+static void flushDeferredEvictions() {
+    std::lock_guard lock(deferredEvictMutex);
+    for (auto const* queue : deferredEvictions) evictQueueState(queue);
+    deferredEvictions.clear();
+}
+
+// 全局预算的取用与归还；开启租约时只碰本线程的槽，不足时才一次性续租一批
+static int takeGlobalBudget(Config const& cfg, int want) {
+    if (!cfg.budgetLeasing) return takeBudget(gTickBudgetRemaining, want);
+    return takeLeased(threadSlots.local(true), gTickBudgetRemaining, want, cfg.budgetLeaseSize);
+}
+
+// amount 为负表示追加扣除，租约模式下允许暂时欠账，下次续租时补上
+static void returnGlobalBudget(Config const& cfg, int amount) {
+    if (cfg.budgetLeasing) {
+        threadSlots.local(true).lease.fetch_add(amount, std::memory_order_relaxed);
+    } else {
+        gTickBudgetRemaining.fetch_add(amount, std::memory_order_relaxed);
+    }
+}
+
+// 按剩余时间切片和单刻耗时估计（优先用成本模型，其次用策略的平滑值）估算本次最多能放行多少条；切片用完返回 0
+static int timeAllowance(int policyIndex, double modelCostNs, int want) {
+    int64_t remaining = gTickTimeRemainingNs.load(std::memory_order_relaxed);
+    if (remaining <= 0) return 0;
+    double cost = modelCostNs > 0.0 ? modelCostNs : policyNsPerTick[policyIndex];
+    if (cost <= 0.0) return want; // 还没有耗时样本，先放行一次再说
+    double fits = static_cast<double>(remaining) / cost;
+    return std::clamp(static_cast<int>(std::min(fits, static_cast<double>(want))), 1, want);
+}
+
+static void chargeTime(int policyIndex, double elapsedNs, int processed) {
+    gTickTimeRemainingNs.fetch_sub(static_cast<int64_t>(elapsedNs), std::memory_order_relaxed);
+    if (processed <= 0) return;
+    double  sample = elapsedNs / processed;
+    double& cost   = policyNsPerTick[policyIndex];
+    cost           = cost > 0.0 ? cost * 0.8 + sample * 0.2 : sample;
+}
+
+static CostModel::Settings costSettings(Config const& cfg) {
+    return {
+        .unitNs    = cfg.costUnitNs,
+        .minWeight = cfg.costMinWeight,
+        .maxWeight = std::max(cfg.costMinWeight, cfg.costMaxWeight),
+    };
+}
+
+// 计划刻数折算成成本单位，向上取整，保证每处理一条至少扣一个单位的零头
+static int costUnits(int ticks, double weight) {
+    if (ticks <= 0) return 0;
+    return std::max(1, static_cast<int>(std::ceil(static_cast<double>(ticks) * weight)));
+}
+
+// 附近区块先用预留，不够再和远处区块一起抢共享的全局预算
+static int takeNearBudget(Config const& cfg, int want) {
+    int fromReserve = takeBudget(gNearBudgetRemaining, want);
+    proximityCounters.reserveUsed += static_cast<uint64_t>(fromReserve);
+    if (fromReserve >= want) return fromReserve;
+    return fromReserve + takeGlobalBudget(cfg, want - fromReserve);
+}
+
+// 依次从区域 / 维度池、策略预算和全局预算中申请额度，返回 0 表示被限流
+// 只在服务器线程上调用（BudgetPools 非线程安全），其它线程上的调用走租约路径，不碰区域 / 维度池
+static int acquireBudget(Config const& cfg, int policyIndex, int dimension, int chunkX, int chunkZ, int want, bool nearby) {
+    int pooled = budgetPools.acquire(dimension, chunkX, chunkZ, want);
+    if (pooled <= 0) return 0;
+
+    bool policyLimited = activePolicies[policyIndex].globalBudgetPerTick > 0;
+    int  granted       = pooled;
+    if (policyLimited) granted = takeBudget(policyBudgetRemaining[policyIndex], granted);
+    if (granted > 0) {
+        int global = nearby ? takeNearBudget(cfg, granted) : takeGlobalBudget(cfg, granted);
+        if (policyLimited && global < granted) {
+            policyBudgetRemaining[policyIndex].fetch_add(granted - global, std::memory_order_relaxed);
+        }
+        granted = global;
+    }
+
+    budgetPools.release(dimension, chunkX, chunkZ, pooled - granted);
+    return granted;
+}
+
+// 按实际处理量结算 acquireBudget 拿到的额度：delta > 0 退回没用掉的部分，delta < 0 追加扣除超出的部分
+static void settleBudget(Config const& cfg, int policyIndex, int dimension, int chunkX, int chunkZ, int delta) {
+    if (delta == 0) return;
+    budgetPools.release(dimension, chunkX, chunkZ, delta);
+    if (activePolicies[policyIndex].globalBudgetPerTick > 0) {
+        policyBudgetRemaining[policyIndex].fetch_add(delta, std::memory_order_relaxed);
+    }
+    returnGlobalBudget(cfg, delta);
+}
+
+// ── trace 录制 ────────────────────────────────────────────
+
+static bool tracing(Config const& cfg) { return cfg.traceEnabled && onServerThread && tracer.running(); }
+
+// 类型编号与成本模型共用，第一次出现时把名称写进 trace
+static uint32_t traceType(Block const* block) {
+    uint32_t type = costModel.typeOf(block, [block]() -> std::string const& { return block->getTypeName(); });
+    if (type != CostModel::kNoType) tracer.nameType(type, costModel.nameOf(type));
+    return type;
+}
+
+static uint32_t traceNs(uint64_t elapsed) {
+    return static_cast<uint32_t>(std::min(tscToNs(elapsed), static_cast<double>(UINT32_MAX)));
+}
+
+// ── 热点分析 ──────────────────────────────────────────────
+
+static bool shouldProfile(Config const& cfg) {
+    if (!cfg.profilerEnabled || !onServerThread) return false;
+    if (profileCountdown > 0) {
+        --profileCountdown;
+        return false;
+    }
+    profileCountdown = std::max(1, cfg.profilerSampleRate) - 1;
+    return true;
+}
+
+// 采样到的调用按采样率放大，近似代表全部调用
+static void recordHotSpot(Config const& cfg, int dimension, int chunkX, int chunkZ, uint64_t elapsedTsc, size_t processed) {
+    double scale = std::max(1, cfg.profilerSampleRate);
+    hotSpots.record(
+        packChunkKey(dimension, chunkX, chunkZ),
+        tscToNs(elapsedTsc) * scale,
+        static_cast<uint64_t>(static_cast<double>(processed) * scale)
+    );
+}
+
+static std::vector<std::string> formatHotSpots(std::vector<HotSpotTracker::Entry> const& top) {
+    std::vector<std::string> lines;
+    for (size_t i = 0; i < top.size(); ++i) {
+        auto const& entry = top[i];
+        auto        chunk = unpackChunkKey(entry.key);
+        lines.push_back(fmt::format(
+            "HotSpot #{} | dim {} chunk ({}, {}) | {:.2f} ms (error <= {:.2f}) | ticks: {} | calls: {}",
+            i + 1,
+            chunk.dimension,
+            chunk.x,
+            chunk.z,
+            entry.cost / 1e6,
+            entry.error / 1e6,
+            entry.ticks,
+            entry.calls
+        ));
+    }
+    return lines;
+}
+
+// ── 负载归属 ──────────────────────────────────────────────
+
+static bool penaltyActive(Config const& cfg) {
+    return cfg.attributionPenalty && cfg.attributionEnabled && cfg.profilerEnabled && onServerThread
+        && attribution.hasPenalties();
+}
+
+// 惩罚档把需求压到配置的比例，至少留一条，队列不会被完全卡死
+static int penalize(Config const& cfg, int want) {
+    attribution.onPenalized();
+    return std::max(1, want * std::clamp(cfg.attributionPenaltyPct, 0, 100) / 100);
+}
+
+// 每个统计周期按当前热点表重新归属，标记状态变化时记日志
+static void attributeLoad(Config const& cfg) {
+    attribution.beginSnapshot();
+    if (auto level = ll::service::getLevel()) {
+        level->forEachPlayer([](Player& player) {
+            auto const& pos = player.getPosition();
+            attribution.addPlayer(
+                attribution.playerId(player.getRealName()),
+                player.getDimensionId().id,
+                static_cast<int>(std::floor(pos.x)) >> 4,
+                static_cast<int>(std::floor(pos.z)) >> 4
+            );
+            return true;
+        });
+    }
+    auto window  = static_cast<uint32_t>(std::max(1, cfg.attributionWindowTicks));
+    auto changes = attribution.attribute(
+        hotSpots.top(hotSpots.size()),
+        {
+            .placementWindow = window,
+            .nearbyRadius    = std::max(0, cfg.attributionRadius),
+            .flagMs          = cfg.attributionFlagMs,
+        },
+        serverTick
+    );
+    for (auto const& change : changes) {
+        if (change.flagged) {
+            logger().warn(
+                "Player {} flagged for pending tick load | {:.2f} ms over {} hot chunks ({} by placement){}",
+                change.name,
+                change.loadMs,
+                change.chunks,
+                change.placed,
+                cfg.attributionPenalty ? " | chunks moved to penalty tier" : ""
+            );
+        } else {
+            logger().info("Player {} no longer flagged | {:.2f} ms over {} hot chunks", change.name, change.loadMs, change.chunks);
+        }
+    }
+    attribution.expire(serverTick, window);
+}
+
+std::vector<std::string> hotSpotReport(size_t count) { return formatHotSpots(hotSpots.top(count)); }
+
+void resetHotSpots() { hotSpots.clear(); }
+
+bool dumpHotSpots() {
+    auto const& cfg   = currentConfig();
+    auto        spots = nlohmann::json::array();
+    for (auto const& entry : hotSpots.top(hotSpots.size())) {
+        auto chunk = unpackChunkKey(entry.key);
+        spots.push_back({
+            {"dimension", chunk.dimension},
+            {"chunkX",    chunk.x        },
+            {"chunkZ",    chunk.z        },
+            {"costMs",    entry.cost / 1e6 },
+            {"errorMs",   entry.error / 1e6},
+            {"ticks",     entry.ticks    },
+            {"calls",     entry.calls    },
+        });
+    }
+    nlohmann::json out{
+        {"timestamp",  std::chrono::duration_cast<std::chrono::seconds>(
+                          std::chrono::system_clock::now().time_since_epoch()
+                      ).count()},
+        {"sampleRate", std::max(1, cfg.profilerSampleRate)},
+        {"hotspots",   std::move(spots)},
+    };
+
+    auto const&     dir = PluginImpl::getInstance().getSelf().getDataDir();
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    std::ofstream file(dir / "hotspots.json");
+    file << out.dump(4);
+    if (!file) {
+        logger().warn("Failed to write hotspots.json");
+        return false;
+    }
+    return true;
 }
 
 // ── Hook ──────────────────────────────────────────────────
@@ -74,15 +933,123 @@ LL_TYPE_INSTANCE_HOOK(
     &Level::$tick,
     void
 ) {
-    if (pluginEnabled.load(std::memory_order_relaxed)
-        && config.enabled
-        && config.budgetEnabled) {
-        gTickBudgetRemaining.store(
-            std::max(1, config.globalBudgetPerTick),
-            std::memory_order_relaxed
+    auto const& cfg = currentConfig();
+    onServerThread  = true;
+    ++serverTick;
+    settleTickAllocations();
+    tickArena.reset();
+    AllocScope allocScope;
+    flushDeferredEvictions();
+    if (!retiredConfigs.empty()) reclaimRetiredConfigs(serverTick);
+    if (analyzer.running()) analyzer.beginTick();
+    if (cfg.compactionEnabled) {
+        compactor.beginTick({
+            .ratio    = std::clamp(cfg.compactionRatio, 0.0, 1.0),
+            .minDead  = static_cast<uint32_t>(std::max(1, cfg.compactionMinDead)),
+            .budgetNs = static_cast<uint64_t>(std::max(0, cfg.compactionBudgetUs)) * 1000,
+        });
+    }
+    bool budgeting  = pluginEnabled.load(std::memory_order_relaxed) && cfg.enabled && cfg.budgetEnabled;
+    int  tickBudget = 0;
+    if (budgeting) {
+        int global = cfg.adaptiveBudget ? adaptive.budget() : std::max(1, cfg.globalBudgetPerTick);
+        tickBudget = global;
+        // time 模式下全局预算是微秒切片，计数预算换成安全上限
+        if (timeSliced) {
+            gTickTimeRemainingNs.store(static_cast<int64_t>(global) * 1000, std::memory_order_relaxed);
+            global = std::max(1, cfg.budgetSafetyLimit);
+        }
+        if (cfg.burstLimiting || cfg.backlogSmoothing) {
+            burst.beginTick({
+                .capacity        = cfg.burstLimiting ? std::max(1, cfg.burstCapacity) : 0,
+                .refillPerTick   = cfg.burstRefillPerTick,
+                .smoothThreshold = cfg.backlogSmoothing ? std::max(1, cfg.backlogThreshold) : 0,
+                .smoothTicks     = cfg.backlogSmoothTicks,
+            });
+        }
+        int reserved = starvation.beginTick(
+            {
+                .reserveBudget      = global * std::clamp(cfg.starvationReservePct, 0, 100) / 100,
+                .maxStarvationTicks = cfg.maxStarvationTicks,
+            },
+            tickArena
         );
+        // 玩家位置快照，附近区块从共享预算里预留一份
+        int nearReserve = 0;
+        if (cfg.proximityPriority) {
+            proximity.beginSnapshot();
+            this->forEachPlayer([](Player& player) {
+                auto const& pos = player.getPosition();
+                proximity.addPlayer(
+                    player.getDimensionId().id,
+                    static_cast<int>(std::floor(pos.x)) >> 4,
+                    static_cast<int>(std::floor(pos.z)) >> 4
+                );
+                return true;
+            });
+            proximity.endSnapshot();
+            if (proximity.hasNearTargets()) {
+                nearReserve = (global - reserved) * std::clamp(cfg.nearReservePct, 0, 100) / 100;
+            }
+        }
+        gNearBudgetRemaining.store(nearReserve, std::memory_order_relaxed);
+
+        // 上一 tick 之后才退回的零星租约作废，本 tick 重新分配
+        threadSlots.reclaimLeases();
+        gTickBudgetRemaining.store(global - reserved - nearReserve, std::memory_order_relaxed);
+        for (size_t i = 0; i < activePolicies.size(); ++i) {
+            policyBudgetRemaining[i].store(activePolicies[i].globalBudgetPerTick, std::memory_order_relaxed);
+        }
+        budgetPools.beginTick({
+            .dimension = cfg.dimensionBudgetPerTick,
+            .area      = cfg.areaBudgetPerTick,
+            .areaShift = std::clamp(cfg.areaChunkShift, 0, 8),
+            .rollover  = cfg.budgetRollover,
+        });
     }
-    return origin();
+
+    // 不限流时也计时，MSPT 分布是导出指标的一部分；一次 steady_clock 读取相对整个 tick 可以忽略
+    auto begin = std::chrono::steady_clock::now();
+    allocScope.pause();
+    origin();
+    allocScope.resume();
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+    auto elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    if (analyzer.running()) analyzer.endTick();
+    tickLatency.record(static_cast<uint64_t>(elapsedNs));
+    if (tracing(cfg)) {
+        tracer.record({
+            .kind      = trace::RecordKind::Tick,
+            .tick      = serverTick,
+            .queueSize = static_cast<uint32_t>(tickBudget),
+            .elapsedNs = static_cast<uint32_t>(std::min<int64_t>(elapsedNs, UINT32_MAX)),
+        });
+    }
+    if (!budgeting) return;
+    double mspt = std::chrono::duration<double, std::milli>(elapsed).count();
+
+    if (timeSliced && gTickTimeRemainingNs.load(std::memory_order_relaxed) <= 0) ++timeExhaustedTicks;
+
+    // 各线程用剩的租约在 tick 结束时归还全局预算
+    if (cfg.budgetLeasing) {
+        int left = threadSlots.reclaimLeases();
+        gTickBudgetRemaining.fetch_add(left, std::memory_order_relaxed);
+        if (left > 0) leaseReturned += static_cast<uint64_t>(left);
+    }
+    if (!cfg.adaptiveBudget) return;
+
+    adaptive.update(
+        mspt,
+        {
+            .targetMspt     = cfg.targetMspt,
+            .headroom       = cfg.adaptiveHeadroom,
+            .decreaseFactor = cfg.adaptiveDecrease,
+            .increaseStep   = cfg.adaptiveIncrease,
+            .minBudget      = cfg.adaptiveMinBudget,
+            .maxBudget      = cfg.adaptiveMaxBudget,
+            .cooldownTicks  = cfg.adaptiveCooldown,
+        }
+    );
 }
 
 LL_TYPE_INSTANCE_HOOK(
@@ -96,87 +1063,930 @@ LL_TYPE_INSTANCE_HOOK(
     int          max,
     bool         instaTick_
 ) {
-    if (!pluginEnabled.load(std::memory_order_relaxed) || !config.enabled || !config.budgetEnabled) {
+    AllocScope  allocScope;
+    auto const& cfg = currentConfig();
+    if (!pluginEnabled.load(std::memory_order_relaxed) || !cfg.enabled || !cfg.budgetEnabled) {
         return origin(region, until, max, instaTick_);
     }
 
-    // 非纯 portal 队列直接放行，零开销
-    if (!isPortalOnlyQueue(this->mNextTickQueue.mC)) {
-        return origin(region, until, max, instaTick_);
+    if (onServerThread) {
+        if (cfg.coalesceEnabled) coalesceQueue(cfg, *this);
+        if (cfg.compactionEnabled) compactQueue(*this);
     }
 
-    totalCallCount.fetch_add(1, std::memory_order_relaxed);
+    // 其它线程上的调用：分类器和各调度模块只在服务器线程上用，这里只按全局预算限量，
+    // 额度从本线程的租约里取，和服务器线程各自续租、互不争用
+    if (!onServerThread && cfg.budgetLeasing) {
+        auto& tally = threadSlots.local(true).offThread;
+        int   want  = std::min(max, static_cast<int>(this->mNextTickQueue.mC.size()));
+        if (want <= 0) return origin(region, until, max, instaTick_);
+        tally.calls.fetch_add(1, std::memory_order_relaxed);
+        tally.queued.fetch_add(this->mNextTickQueue.mC.size(), std::memory_order_relaxed);
+        int granted = takeGlobalBudget(cfg, want);
+        if (granted < want) tally.capped.fetch_add(1, std::memory_order_relaxed);
+        if (granted <= 0) return false;
+        auto drain = drainPartial(*this, granted, [&](int limit) { return origin(region, until, limit, instaTick_); });
+        returnGlobalBudget(cfg, granted - drain.ran);
+        tally.processed.fetch_add(static_cast<uint64_t>(drain.ran), std::memory_order_relaxed);
+        return drain.result;
+    }
 
-    // 单次调用限制
-    if (max > config.budgetPerTick) {
-        max = config.budgetPerTick;
+    // 未命中任何策略的队列直接放行，通常只需一次查表
+    int policyIndex = onServerThread ? classifyQueue(cfg, *this) : -1;
+    if (policyIndex < 0) {
+        bool     profile  = shouldProfile(cfg) && !this->mNextTickQueue.mC.empty();
+        bool     trace    = tracing(cfg) && !this->mNextTickQueue.mC.empty();
+        int      chunkX   = 0;
+        int      chunkZ   = 0;
+        uint32_t headType = CostModel::kNoType;
+        if (profile || trace) {
+            auto const& head = this->mNextTickQueue.mC.front().mData;
+            chunkX           = head.mPos.x >> 4;
+            chunkZ           = head.mPos.z >> 4;
+            if (trace) headType = traceType(head.mBlock);
+        }
+        auto drain = drainPartial(*this, max, [&](int limit) { return origin(region, until, limit, instaTick_); });
+        if (cfg.latencyTiming) passThroughLatency.record(drain.elapsed);
+        if (profile) {
+            recordHotSpot(cfg, region.getDimensionId().id, chunkX, chunkZ, drain.elapsed, static_cast<size_t>(drain.ran));
+        }
+        if (trace) {
+            tracer.record({
+                .kind      = trace::RecordKind::Call,
+                .dimension = static_cast<int8_t>(region.getDimensionId().id),
+                .policy    = -1,
+                .tick      = serverTick,
+                .queue     = tracer.queueId(this),
+                .queueSize = static_cast<uint32_t>(drain.sizeBefore),
+                .chunkX    = chunkX,
+                .chunkZ    = chunkZ,
+                .max       = max,
+                .want      = max,
+                .allowed   = max,
+                .processed = drain.ran,
+                .elapsedNs = traceNs(drain.elapsed),
+                .headType  = headType,
+            });
+        }
+        // QueueTracker 不是线程安全的，与其它调用一样只在服务器线程上更新
+        if (onServerThread) {
+            queueTracker.onDrained(this, drain.remaining, drain.adds);
+            if (cfg.portalSuppression) portals.onDrained(this);
+            if (analyzer.running()) captureForAnalysis(cfg, *this, drain.remaining);
+        }
+        return drain.result;
     }
 
-    // 全局预算限制
-    int remaining = gTickBudgetRemaining.load(std::memory_order_relaxed);
-    if (remaining <= 0) {
-        totalCapped.fetch_add(1, std::memory_order_relaxed);
-        return false;
+    auto const& policy   = activePolicies[policyIndex];
+    auto&       counters = threadSlots.local(cfg.budgetLeasing).policies[policyIndex];
+    int         maxArg   = max;
+    counters.calls.fetch_add(1, std::memory_order_relaxed);
+
+    // 单次调用限制；队列长度是本次能处理的上限，超出的部分不算需求
+    if (max > policy.budgetPerCall) {
+        max = policy.budgetPerCall;
+    }
+    max = std::min(max, static_cast<int>(this->mNextTickQueue.mC.size()));
+    // 令牌桶和积压平滑压低的是需求本身，不算被限流，也不会让队列进入饥饿
+    if (cfg.burstLimiting || cfg.backlogSmoothing) {
+        max = burst.limit(this, max, this->mNextTickQueue.mC.size(), cfg.burstLimiting);
+    }
+
+    // 饥饿队列先认领预留额度，不足部分再走区域 / 维度 / 策略 / 全局预算
+    // 命中策略的队列必然非空，用第一条的位置定位区块
+    int         dimension = region.getDimensionId().id;
+    auto&       dimTally  = dimensionTally(dimension);
+    auto const& firstPos  = this->mNextTickQueue.mC.front().mData.mPos;
+    int         chunkX    = firstPos.x >> 4;
+    int         chunkZ    = firstPos.z >> 4;
+    bool        nearby    = false;
+    if (cfg.proximityPriority) {
+        nearby = proximity.tierOf(dimension, chunkX, chunkZ) == ProximityTiers::Tier::Near;
+        ++(nearby ? proximityCounters.nearCalls : proximityCounters.farCalls);
+    }
+    // 惩罚档：被标记玩家名下的热点区块不用附近预留，需求按比例压低；和令牌桶一样不算被限流
+    if (penaltyActive(cfg) && attribution.penalized(packChunkKey(dimension, chunkX, chunkZ))) {
+        nearby = false;
+        max    = penalize(cfg, max);
     }
 
-    int allowed = std::min(max, remaining);
-    while (!gTickBudgetRemaining.compare_exchange_weak(
-        remaining,
-        remaining - allowed,
-        std::memory_order_relaxed,
-        std::memory_order_relaxed
-    )) {
-        if (remaining <= 0) {
-            totalCapped.fetch_add(1, std::memory_order_relaxed);
-            return false;
+    // 成本模型按队首方块的类型估计本次调用的单刻成本，预算池里的额度以成本单位计
+    uint32_t costType = CostModel::kNoType;
+    double   weight   = 1.0;
+    if (cfg.costModelEnabled) {
+        auto const* headBlock = this->mNextTickQueue.mC.front().mData.mBlock;
+        costType = costModel.typeOf(headBlock, [headBlock]() -> std::string const& { return headBlock->getTypeName(); });
+        weight   = costModel.weight(costType, costSettings(cfg));
+    }
+    bool     trace    = tracing(cfg);
+    uint32_t headType = trace ? traceType(this->mNextTickQueue.mC.front().mData.mBlock) : CostModel::kNoType;
+
+    auto claim = starvation.claim(this, max);
+    if (claim.released > 0) returnGlobalBudget(cfg, claim.released);
+    int pooled      = 0; // 成本单位
+    int pooledTicks = 0;
+    if (claim.granted < max) {
+        int want = max - claim.granted;
+        if (timeSliced) {
+            int fits = timeAllowance(policyIndex, costModel.costNs(costType), want);
+            if (fits < want) timeCappedCalls.fetch_add(1, std::memory_order_relaxed);
+            want = fits;
+        }
+        if (want > 0) {
+            pooled      = acquireBudget(cfg, policyIndex, dimension, chunkX, chunkZ, costUnits(want, weight), nearby);
+            pooledTicks = std::min(want, static_cast<int>(static_cast<double>(pooled) / weight));
+        }
+    }
+    int allowed = claim.granted + pooledTicks;
+
+    if (allowed < max) {
+        starvation.onCapped(this, max);
+    } else {
+        starvation.onServed(this);
+    }
+
+    if (allowed <= 0) {
+        // 拿到的成本单位不够一条时原样退回
+        if (pooled > 0) settleBudget(cfg, policyIndex, dimension, chunkX, chunkZ, pooled);
+        counters.capped.fetch_add(1, std::memory_order_relaxed);
+        dimTally.calls.fetch_add(1, std::memory_order_relaxed);
+        dimTally.capped.fetch_add(1, std::memory_order_relaxed);
+        if (trace) {
+            tracer.record({
+                .kind      = trace::RecordKind::Call,
+                .dimension = static_cast<int8_t>(dimension),
+                .policy    = static_cast<int8_t>(policyIndex),
+                .flags     = static_cast<uint8_t>(nearby ? trace::kFlagNear : 0),
+                .tick      = serverTick,
+                .queue     = tracer.queueId(this),
+                .queueSize = static_cast<uint32_t>(this->mNextTickQueue.mC.size()),
+                .chunkX    = chunkX,
+                .chunkZ    = chunkZ,
+                .max       = maxArg,
+                .want      = max,
+                .headType  = headType,
+            });
         }
-        allowed = std::min(max, remaining);
+        return false;
     }
 
-    totalQueued.fetch_add(this->mNextTickQueue.mC.size(), std::memory_order_relaxed);
+    counters.queued.fetch_add(this->mNextTickQueue.mC.size(), std::memory_order_relaxed);
 
+    dimTally.calls.fetch_add(1, std::memory_order_relaxed);
     if (allowed < max) {
-        totalCapped.fetch_add(1, std::memory_order_relaxed);
+        counters.capped.fetch_add(1, std::memory_order_relaxed);
+        dimTally.capped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // 只出队 allowed 条，剩下的留到后续 tick；计费和统计都按实际出队数
+    auto   drain     = drainPartial(*this, allowed, [&](int limit) { return origin(region, until, limit, instaTick_); });
+    int    processed = drain.ran;
+    auto   elapsed   = drain.elapsed;
+    double elapsedNs = tscToNs(elapsed);
+    if (cfg.latencyTiming) throttledLatency.record(elapsed);
+    if (timeSliced) chargeTime(policyIndex, elapsedNs, processed);
+    if (cfg.costModelEnabled) costModel.record(costType, elapsedNs, processed);
+    if (cfg.burstLimiting) burst.consume(this, processed);
+    if (shouldProfile(cfg)) recordHotSpot(cfg, dimension, chunkX, chunkZ, elapsed, static_cast<size_t>(processed));
+    if (trace) {
+        tracer.record({
+            .kind      = trace::RecordKind::Call,
+            .dimension = static_cast<int8_t>(dimension),
+            .policy    = static_cast<int8_t>(policyIndex),
+            .flags     = static_cast<uint8_t>((nearby ? trace::kFlagNear : 0) | (claim.forced ? trace::kFlagForced : 0)),
+            .tick      = serverTick,
+            .queue     = tracer.queueId(this),
+            .queueSize = static_cast<uint32_t>(drain.sizeBefore),
+            .chunkX    = chunkX,
+            .chunkZ    = chunkZ,
+            .max       = maxArg,
+            .want      = max,
+            .allowed   = allowed,
+            .processed = processed,
+            .elapsedNs = traceNs(elapsed),
+            .headType  = headType,
+        });
+    }
+    queueTracker.onDrained(this, drain.remaining, drain.adds);
+    if (cfg.portalSuppression) portals.onDrained(this);
+    if (analyzer.running()) captureForAnalysis(cfg, *this, drain.remaining);
+
+    // 按实际出队数计费：先抵扣预留额度，其余从普通预算路径结算，多退少补
+    int fromClaim = std::min(processed, claim.granted);
+    settleBudget(cfg, policyIndex, dimension, chunkX, chunkZ, pooled - costUnits(processed - fromClaim, weight));
+    if (!claim.forced && claim.granted > fromClaim) {
+        returnGlobalBudget(cfg, claim.granted - fromClaim);
+    }
+    counters.processed.fetch_add(static_cast<uint64_t>(processed), std::memory_order_relaxed);
+    dimTally.processed.fetch_add(static_cast<uint64_t>(processed), std::memory_order_relaxed);
+    return drain.result;
+}
+
+// add / remove 维护增量计数，其它线程（如世界生成）上的修改交给大小校验兜底
+LL_TYPE_INSTANCE_HOOK(
+    QueueAddHook,
+    ll::memory::HookPriority::Normal,
+    BlockTickingQueue,
+    &BlockTickingQueue::add,
+    void,
+    BlockSource&    region,
+    BlockPos const& pos,
+    Block const&    block,
+    int             tickDelay,
+    int             priorityOffset
+) {
+    AllocScope allocScope;
+    // 邻域没变的传送门不再排校验刻
+    if (onServerThread && currentConfig().portalSuppression && pluginEnabled.load(std::memory_order_relaxed)) {
+        bool portal = portalClassifier.classify(&block, [&block]() -> std::string const& {
+            return block.getTypeName();
+        }) != 0;
+        if (portal && portals.suppress(this, region.getDimensionId().id, pos.x >> 4, pos.z >> 4)) return;
+    }
+    origin(region, pos, block, tickDelay, priorityOffset);
+    if (drainingQueue == this) ++drainAdds;
+    if (!onServerThread || !queueTracker.find(this)) return;
+    queueTracker.onAdd(this, policyMaskOf(&block), this->mNextTickQueue.mC.size(), drainingQueue == this);
+}
+
+LL_TYPE_INSTANCE_HOOK(
+    QueueRemoveHook,
+    ll::memory::HookPriority::Normal,
+    BlockTickingQueue,
+    &BlockTickingQueue::remove,
+    void,
+    BlockPos const& pos,
+    Block const&    block
+) {
+    AllocScope allocScope;
+    origin(pos, block);
+    if (!onServerThread) return;
+    auto const& cfg = currentConfig();
+    if (cfg.compactionEnabled) compactor.onTombstoned(this, 1);
+    // remove 只打墓碑、长度不变，后台结果按长度核对认不出来，必须在这里作废
+    analyzer.invalidate(this);
+    if (!queueTracker.find(this)) return;
+    queueTracker.onRemove(this, policyMaskOf(&block));
+}
+
+// 传送门邻域的方块变化。其它线程上的 setBlock 来自生成或加载中的区块，那里还没有在 tick 的传送门
+LL_TYPE_INSTANCE_HOOK(
+    ChunkSetBlockHook,
+    ll::memory::HookPriority::Normal,
+    LevelChunk,
+    &LevelChunk::setBlock,
+    Block const&,
+    ChunkBlockPos const&        pos,
+    Block const&                block,
+    BlockSource*                issuingSource,
+    std::shared_ptr<BlockActor> blockEntity
+) {
+    AllocScope   allocScope;
+    Block const& previous = origin(pos, block, issuingSource, std::move(blockEntity));
+    if (onServerThread && currentConfig().portalSuppression) {
+        auto const& chunk = this->getPosition();
+        portals.onBlockChanged(this->getDimension().getDimensionId().id, chunk.x, chunk.z);
+    }
+    return previous;
+}
+
+// 区块卸载：两条队列是 LevelChunk 的成员，析构可能被内联进 LevelChunk 的析构函数而绕过 QueueDtorHook，
+// 这里按成员地址再驱逐一次；重复驱逐是无害的
+LL_TYPE_INSTANCE_HOOK(ChunkDtorHook, ll::memory::HookPriority::Normal, LevelChunk, &LevelChunk::$dtor, void) {
+    void const* queues[] = {&this->mTickQueue, &this->mRandomTickQueue};
+    if (onServerThread) {
+        for (auto const* queue : queues) evictQueueState(queue);
+    } else {
+        std::lock_guard lock(deferredEvictMutex);
+        deferredEvictions.insert(deferredEvictions.end(), std::begin(queues), std::end(queues));
+    }
+    origin();
+}
+
+// 区块卸载时队列随 LevelChunk 析构，对应的计数一起驱逐
+LL_TYPE_INSTANCE_HOOK(
+    QueueDtorHook,
+    ll::memory::HookPriority::Normal,
+    BlockTickingQueue,
+    &BlockTickingQueue::$dtor,
+    void
+) {
+    if (onServerThread) {
+        evictQueueState(this);
+    } else {
+        std::lock_guard lock(deferredEvictMutex);
+        deferredEvictions.push_back(this);
+    }
+    origin();
+}
+
+// ── 统计报告 ──────────────────────────────────────────────
+
+// 采集和格式化分开：采集在服务器线程上一次读完所有计数，日志、命令和导出共用同一份快照
+StatsSample collectStats(bool reset) {
+    auto const& cfg = currentConfig();
+    StatsSample sample;
+    auto read = [reset](std::atomic<uint64_t>& value) {
+        return reset ? value.exchange(0, std::memory_order_relaxed) : value.load(std::memory_order_relaxed);
+    };
+    auto readPlain = [reset](uint64_t& value) { return reset ? std::exchange(value, 0) : value; };
+
+    auto now           = std::chrono::system_clock::now().time_since_epoch();
+    sample.timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+    sample.serverTick  = serverTick;
+
+    for (size_t i = 0; i < activePolicies.size(); ++i) {
+        // 汇总各线程槽；关闭租约时只有 0 号槽有数据
+        StatsSample::Policy policy{.name = activePolicies[i].name};
+        threadSlots.forEach([&](ThreadSlot& slot) {
+            auto& tally = slot.policies[i];
+            policy.calls += read(tally.calls);
+            policy.queued += read(tally.queued);
+            policy.capped += read(tally.capped);
+            policy.processed += read(tally.processed);
+        });
+        sample.policies.push_back(std::move(policy));
+    }
+    for (int i = 0; i < BudgetPools::kMaxDimensions; ++i) {
+        auto&                  tally = dimensionTallies[i];
+        StatsSample::Dimension dimension{
+            .dimension = i,
+            .calls     = read(tally.calls),
+            .capped    = read(tally.capped),
+            .processed = read(tally.processed),
+        };
+        if (dimension.calls > 0) sample.dimensions.push_back(dimension);
+    }
+
+    sample.latencyTiming = cfg.latencyTiming;
+    if (cfg.latencyTiming) {
+        double scale         = tscNsPerTick() / 1000.0;
+        sample.throttledUs   = reset ? throttledLatency.takeSummary(scale) : throttledLatency.peekSummary(scale);
+        sample.passThroughUs = reset ? passThroughLatency.takeSummary(scale) : passThroughLatency.peekSummary(scale);
+    }
+    sample.tickMs = reset ? tickLatency.takeSummary(1e-6) : tickLatency.peekSummary(1e-6);
+
+    sample.trackedQueues = queueTracker.size();
+    auto& memory       = sample.memory;
+    memory.queues      = queueTracker.memoryUsage() + coalescer.memoryUsage() + compactor.memoryUsage()
+                       + portals.memoryUsage();
+    memory.scheduling  = starvation.memoryUsage() + burst.memoryUsage();
+    memory.analysis    = analyzer.memoryUsage();
+    memory.classifiers = classifier.memoryUsage() + coalesceClassifier.memoryUsage() + portalClassifier.memoryUsage()
+                       + typeIds.memoryUsage();
+    memory.profiling   = hotSpots.memoryUsage() + costModel.memoryUsage() + tracer.memoryUsage()
+                     + attribution.memoryUsage();
+    memory.pools       = budgetPools.memoryUsage() + proximity.memoryUsage();
+    memory.total       = memory.queues + memory.scheduling + memory.analysis + memory.classifiers + memory.profiling
+                 + memory.pools + tickArena.capacity();
+    sample.sweptQueues = reset ? std::exchange(sweptQueues, 0) : sweptQueues;
+
+    sample.arenaBytes     = tickArena.capacity();
+    sample.arenaPeak      = tickArena.highWater();
+    sample.arenaOverflows = reset ? tickArena.takeOverflows() : tickArena.overflows();
+    sample.allocTracking  = kAllocTracking;
+    if (kAllocTracking) {
+        sample.hotPathTicks           = allocTally.ticks;
+        sample.hotPathAllocatingTicks = allocTally.allocatingTicks;
+        sample.hotPathAllocations     = allocTally.allocations;
+        if (reset) allocTally = {};
+    }
+    sample.analysis      = analyzer.running();
+    if (sample.analysis) {
+        sample.analysisCounters = reset ? analyzer.takeCounters() : analyzer.counters();
+        sample.analysisResults  = analyzer.results();
+    }
+    sample.cachedBlocks  = classifier.cachedCount();
+    sample.globalBudget  = cfg.adaptiveBudget ? adaptive.budget() : cfg.globalBudgetPerTick;
+    sample.pools         = reset ? budgetPools.takeCounters() : budgetPools.counters();
+    sample.trackedAreas  = budgetPools.trackedAreas();
+
+    sample.starvation     = reset ? starvation.takeCounters() : starvation.counters();
+    sample.starvingQueues = starvation.starving();
+
+    sample.burst = cfg.burstLimiting || cfg.backlogSmoothing;
+    if (sample.burst) {
+        sample.burstCounters = reset ? burst.takeCounters() : burst.counters();
+        sample.burstQueues   = burst.queues();
+    }
+
+    sample.adaptive = cfg.adaptiveBudget;
+    if (cfg.adaptiveBudget) {
+        sample.adaptiveState = adaptive.state();
+        sample.targetMspt    = cfg.targetMspt;
+    }
+
+    sample.timeSliced = timeSliced;
+    if (timeSliced) {
+        sample.timeExhaustedTicks = readPlain(timeExhaustedTicks);
+        sample.timeCappedCalls    = read(timeCappedCalls);
+    }
+
+    sample.coalesce = cfg.coalesceEnabled;
+    if (cfg.coalesceEnabled) {
+        sample.merged         = reset ? coalescer.takeMerged() : coalescer.merged();
+        sample.coalesceQueues = coalescer.trackedQueues();
+    }
+
+    sample.portal = cfg.portalSuppression;
+    if (cfg.portalSuppression) {
+        sample.portalCounters = reset ? portals.takeCounters() : portals.counters();
+        sample.portalChunks   = portals.portals();
+        sample.portalWatched  = portals.watched();
+    }
+
+    sample.compaction = cfg.compactionEnabled;
+    if (cfg.compactionEnabled) {
+        sample.compacted         = reset ? compactor.takeCounters() : compactor.counters();
+        sample.compactionPending = compactor.pending();
+    }
+
+    sample.leasing = cfg.budgetLeasing;
+    if (cfg.budgetLeasing) {
+        threadSlots.forEach([&](ThreadSlot& slot) {
+            sample.leaseRefills       += read(slot.refills);
+            sample.offThreadCalls     += read(slot.offThread.calls);
+            sample.offThreadCapped    += read(slot.offThread.capped);
+            sample.offThreadProcessed += read(slot.offThread.processed);
+        });
+        sample.leaseThreads  = threadSlots.threads();
+        sample.leaseReturned = readPlain(leaseReturned);
+    }
+
+    sample.proximity = cfg.proximityPriority;
+    if (cfg.proximityPriority) {
+        auto counters      = reset ? std::exchange(proximityCounters, {}) : proximityCounters;
+        sample.players     = proximity.players();
+        sample.nearCells   = proximity.nearCells();
+        sample.nearCalls   = counters.nearCalls;
+        sample.farCalls    = counters.farCalls;
+        sample.reserveUsed = counters.reserveUsed;
+    }
+
+    sample.costModel = cfg.costModelEnabled;
+    if (cfg.costModelEnabled) {
+        sample.costSettings = costSettings(cfg);
+        sample.costTop      = costModel.top(3);
     }
 
-    return origin(region, until, max, allowed);
+    sample.profiler = cfg.profilerEnabled;
+    if (cfg.profilerEnabled) sample.hotSpots = hotSpots.top(static_cast<size_t>(std::max(0, cfg.profilerLogTop)));
+
+    sample.attribution = cfg.attributionEnabled && cfg.profilerEnabled;
+    if (sample.attribution) {
+        sample.penalty             = cfg.attributionPenalty;
+        sample.attributionCounters = reset ? attribution.takeCounters() : attribution.counters();
+        sample.flaggedPlayers      = attribution.flagged();
+        sample.penalizedChunks     = attribution.penalizedChunks();
+        sample.placements          = attribution.placements();
+        sample.attributedPlayers   = attribution.top(static_cast<size_t>(std::max(0, cfg.attributionLogTop)));
+    }
+    return sample;
+}
+
+static std::vector<std::string> formatStats(StatsSample const& sample) {
+    std::vector<std::string> lines;
+
+    for (auto const& policy : sample.policies) {
+        auto calls = static_cast<float>(policy.calls);
+        lines.push_back(fmt::format(
+            "Policy {} | calls: {} | avg queue: {:.1f} | processed: {} | capped: {} ({:.1f}%)",
+            policy.name,
+            policy.calls,
+            policy.calls > 0 ? static_cast<float>(policy.queued) / calls : 0.0f,
+            policy.processed,
+            policy.capped,
+            policy.calls > 0 ? static_cast<float>(policy.capped) / calls * 100.0f : 0.0f
+        ));
+    }
+
+    auto latency = [&](char const* label, LatencyHistogram::Summary const& summary, char const* unit) {
+        lines.push_back(fmt::format(
+            "Latency {} | n: {} | p50: {:.1f}{} | p99: {:.1f}{} | p999: {:.1f}{} | max: {:.1f}{}",
+            label,
+            summary.count,
+            summary.p50,
+            unit,
+            summary.p99,
+            unit,
+            summary.p999,
+            unit,
+            summary.max,
+            unit
+        ));
+    };
+    if (sample.latencyTiming) {
+        latency("throttled", sample.throttledUs, "us");
+        latency("pass-through", sample.passThroughUs, "us");
+    }
+    latency("level tick", sample.tickMs, "ms");
+
+    if (sample.profiler) {
+        auto spots = formatHotSpots(sample.hotSpots);
+        lines.insert(lines.end(), spots.begin(), spots.end());
+    }
+    if (sample.attribution) {
+        auto const& counters = sample.attributionCounters;
+        lines.push_back(fmt::format(
+            "Attribution | flagged players: {} | flags: {} | unattributed hot spots: {} | placements: {}",
+            sample.flaggedPlayers,
+            counters.flags,
+            counters.unattributed,
+            sample.placements
+        ));
+        if (sample.penalty) {
+            lines.push_back(fmt::format(
+                "Attribution | penalized chunks: {} | penalized calls: {}",
+                sample.penalizedChunks,
+                counters.penalizedCalls
+            ));
+        }
+        for (size_t i = 0; i < sample.attributedPlayers.size(); ++i) {
+            auto const& player = sample.attributedPlayers[i];
+            lines.push_back(fmt::format(
+                "Attribution #{} | {} | {:.2f} ms | hot chunks: {} ({} by placement){}",
+                i + 1,
+                player.name,
+                player.loadMs,
+                player.chunks,
+                player.placed,
+                player.flagged ? " | flagged" : ""
+            ));
+        }
+    }
+
+    lines.push_back(fmt::format("Tracker | queues: {} | cached blocks: {}", sample.trackedQueues, sample.cachedBlocks));
+
+    auto const& memory = sample.memory;
+    lines.push_back(fmt::format(
+        "Memory | plugin: {} KiB | queues: {} | scheduling: {} | analysis: {} | classifiers: {} | profiling: {} | "
+        "pools: {} | swept queues: {}",
+        memory.total / 1024,
+        memory.queues / 1024,
+        memory.scheduling / 1024,
+        memory.analysis / 1024,
+        memory.classifiers / 1024,
+        memory.profiling / 1024,
+        memory.pools / 1024,
+        sample.sweptQueues
+    ));
+    if (sample.allocTracking) {
+        lines.push_back(fmt::format(
+            "Arena | {} KiB (peak {} KiB) | overflows: {} | hot-path allocations: {} in {}/{} ticks",
+            sample.arenaBytes / 1024,
+            sample.arenaPeak / 1024,
+            sample.arenaOverflows,
+            sample.hotPathAllocations,
+            sample.hotPathAllocatingTicks,
+            sample.hotPathTicks
+        ));
+    } else {
+        lines.push_back(fmt::format(
+            "Arena | {} KiB (peak {} KiB) | overflows: {}",
+            sample.arenaBytes / 1024,
+            sample.arenaPeak / 1024,
+            sample.arenaOverflows
+        ));
+    }
+
+    lines.push_back(fmt::format(
+        "BudgetPools | dimension capped: {} | area capped: {} | rolled over: {} | tracked areas: {}",
+        sample.pools.dimensionCapped,
+        sample.pools.areaCapped,
+        sample.pools.rolledOver,
+        sample.trackedAreas
+    ));
+
+    for (auto const& dimension : sample.dimensions) {
+        lines.push_back(fmt::format(
+            "Dimension {} | calls: {} | capped: {} | processed: {}",
+            dimension.dimension,
+            dimension.calls,
+            dimension.capped,
+            dimension.processed
+        ));
+    }
+
+    if (sample.costModel) {
+        for (auto const& entry : sample.costTop) {
+            lines.push_back(fmt::format(
+                "CostModel | {} | {:.2f}us | weight: {:.2f} | samples: {}",
+                entry.name,
+                entry.ns / 1000.0,
+                CostModel::weightFor(entry.ns, sample.costSettings),
+                entry.samples
+            ));
+        }
+    }
+
+    if (sample.proximity) {
+        lines.push_back(fmt::format(
+            "Proximity | players: {} | near cells: {} | near calls: {} | far calls: {} | reserve used: {}",
+            sample.players,
+            sample.nearCells,
+            sample.nearCalls,
+            sample.farCalls,
+            sample.reserveUsed
+        ));
+    }
+
+    if (sample.timeSliced) {
+        lines.push_back(fmt::format(
+            "TimeSlice | slice: {}us | exhausted ticks: {} | time capped calls: {}",
+            sample.globalBudget,
+            sample.timeExhaustedTicks,
+            sample.timeCappedCalls
+        ));
+    }
+
+    if (sample.coalesce) {
+        lines.push_back(fmt::format("Coalesce | merged: {} | tracked queues: {}", sample.merged, sample.coalesceQueues));
+    }
+
+    if (sample.portal) {
+        lines.push_back(fmt::format(
+            "Portal | suppressed: {} | allowed: {} | invalidations: {} | portal chunks: {} | watched chunks: {}",
+            sample.portalCounters.suppressed,
+            sample.portalCounters.allowed,
+            sample.portalCounters.invalidations,
+            sample.portalChunks,
+            sample.portalWatched
+        ));
+    }
+
+    if (sample.compaction) {
+        lines.push_back(fmt::format(
+            "Compaction | queues: {} | tombstones: {} | reclaimed: {} bytes | released: {} bytes | deferred: {} | "
+            "pending: {}",
+            sample.compacted.queues,
+            sample.compacted.removed,
+            sample.compacted.reclaimed,
+            sample.compacted.released,
+            sample.compacted.deferred,
+            sample.compactionPending
+        ));
+    }
+
+    if (sample.leasing) {
+        lines.push_back(fmt::format(
+            "Leasing | threads: {} | refills: {} | returned: {} | off-thread calls: {} | capped: {} | processed: {}",
+            sample.leaseThreads,
+            sample.leaseRefills,
+            sample.leaseReturned,
+            sample.offThreadCalls,
+            sample.offThreadCapped,
+            sample.offThreadProcessed
+        ));
+    }
+
+    if (sample.adaptive) {
+        auto const& state = sample.adaptiveState;
+        lines.push_back(fmt::format(
+            "Adaptive | budget: {} | mspt: {:.2f} (smoothed {:.2f}, target {:.1f}) | +{} / -{}",
+            state.budget,
+            state.lastMspt,
+            state.smoothMspt,
+            sample.targetMspt,
+            state.increases,
+            state.decreases
+        ));
+    }
+
+    lines.push_back(fmt::format(
+        "Starvation | max age: {} ticks | starving queues: {} | reserved: {} | forced: {}",
+        sample.starvation.maxAge,
+        sample.starvingQueues,
+        sample.starvation.reserved,
+        sample.starvation.forced
+    ));
+
+    if (sample.analysis) {
+        lines.push_back(fmt::format(
+            "Analysis | captured: {} | hits: {} | stale: {} | dropped batches: {} | coalesce skipped: {} | results: {}",
+            sample.analysisCounters.captured,
+            sample.analysisCounters.hits,
+            sample.analysisCounters.stale,
+            sample.analysisCounters.dropped,
+            sample.analysisCounters.coalesceSkipped,
+            sample.analysisResults
+        ));
+    }
+
+    if (sample.burst) {
+        lines.push_back(fmt::format(
+            "Burst | limited calls: {} | deferred ticks: {} | smoothed backlogs: {} | queues: {}",
+            sample.burstCounters.limited,
+            sample.burstCounters.deferred,
+            sample.burstCounters.smoothed,
+            sample.burstQueues
+        ));
+    }
+    return lines;
+}
+
+std::vector<std::string> statsReport(bool reset) { return formatStats(collectStats(reset)); }
+
+std::vector<std::string> budgetReport() {
+    auto const& cfg = currentConfig();
+    return {
+        fmt::format(
+            "Budget | enabled: {} | mode: {} | per call: {} | global: {}{}",
+            cfg.budgetEnabled,
+            timeSliced ? "time" : "count",
+            cfg.budgetPerTick,
+            cfg.adaptiveBudget ? adaptive.budget() : cfg.globalBudgetPerTick,
+            cfg.adaptiveBudget ? " (adaptive)" : ""
+        ),
+        fmt::format(
+            "Budget | dimension: {} | area: {} (shift {}) | starvation reserve: {}% | near reserve: {}%",
+            cfg.dimensionBudgetPerTick,
+            cfg.areaBudgetPerTick,
+            cfg.areaChunkShift,
+            cfg.starvationReservePct,
+            cfg.proximityPriority ? cfg.nearReservePct : 0
+        ),
+        fmt::format(
+            "Budget | remaining this tick: {} | near reserve left: {}",
+            gTickBudgetRemaining.load(std::memory_order_relaxed),
+            gNearBudgetRemaining.load(std::memory_order_relaxed)
+        ),
+    };
+}
+
+std::vector<std::string> traceReport() {
+    return {fmt::format(
+        "Trace | recording: {} | written: {} | dropped: {}",
+        tracer.running(),
+        tracer.written(),
+        tracer.dropped()
+    )};
+}
+
+std::vector<std::string> policyReport() {
+    std::vector<std::string> lines;
+    for (auto const& policy : currentConfig().policies) {
+        lines.push_back(fmt::format(
+            "Policy {} | enabled: {} | match: {} | per call: {} | per tick: {} | blocks: {}",
+            policy.name,
+            policy.enabled,
+            policy.match,
+            policy.budgetPerCall,
+            policy.globalBudgetPerTick,
+            policy.blocks.size()
+        ));
+    }
+    return lines;
 }
 
 // ── 统计输出协程 ──────────────────────────────────────────
 
+static constexpr auto kCostModelSaveInterval = std::chrono::minutes(5);
+
+// 按当前配置启停导出线程；路径变化时重启
+static void syncMetricsExporter(Config const& cfg) {
+    MetricsExporter::Settings settings;
+    if (cfg.metricsEnabled) {
+        auto const& dataDir = PluginImpl::getInstance().getSelf().getDataDir();
+        if (cfg.metricsJsonl) settings.jsonlPath = dataDir / "metrics.jsonl";
+        if (cfg.metricsPrometheus) {
+            settings.prometheusPath = cfg.metricsPrometheusPath.empty()
+                                        ? dataDir / "metrics.prom"
+                                        : std::filesystem::path(cfg.metricsPrometheusPath);
+        }
+        settings.maxJsonlBytes = static_cast<uint64_t>(std::max(0, cfg.metricsMaxFileMb)) << 20;
+    }
+    static MetricsExporter::Settings active;
+    bool wanted = !settings.jsonlPath.empty() || !settings.prometheusPath.empty();
+    if (metrics.running()
+        && (!wanted || settings.jsonlPath != active.jsonlPath || settings.prometheusPath != active.prometheusPath
+            || settings.maxJsonlBytes != active.maxJsonlBytes)) {
+        metrics.stop();
+    }
+    if (wanted && !metrics.running()) {
+        std::error_code ec;
+        std::filesystem::create_directories(PluginImpl::getInstance().getSelf().getDataDir(), ec);
+        active = settings;
+        metrics.start(std::move(settings));
+    }
+}
+
 void startStatsTask() {
     ll::coro::keepThis([]() -> ll::coro::CoroTask<> {
+        auto lastCostModelSave = std::chrono::steady_clock::now();
         while (pluginEnabled.load(std::memory_order_relaxed)) {
-            int interval = getConfig().statsIntervalSec;
+            int interval = currentConfig().statsIntervalSec;
             if (interval < 1) interval = 5;
             co_await std::chrono::seconds(interval);
 
             if (!pluginEnabled.load(std::memory_order_relaxed)) break;
+            if (currentConfig().watchConfig) watchConfigFile();
 
-            if (getConfig().debug) {
-                uint64_t calls  = totalCallCount.load(std::memory_order_relaxed);
-                uint64_t queued = totalQueued.load(std::memory_order_relaxed);
-                uint64_t capped = totalCapped.load(std::memory_order_relaxed);
-                float    capPct = calls > 0
-                    ? static_cast<float>(capped) / static_cast<float>(calls) * 100.0f
-                    : 0.0f;
-
-                logger().info(
-                    "PortalTicks | calls: {} | avg queue: {:.1f} | capped: {} ({:.1f}%)",
-                    calls,
-                    calls > 0 ? static_cast<float>(queued) / static_cast<float>(calls) : 0.0f,
-                    capped,
-                    capPct
-                );
+            auto const& cfg = currentConfig();
+            syncMetricsExporter(cfg);
+            sweepIdleState();
+
+            // 归属在采集之前，本周期的日志和导出看到的是刚算出的分数
+            if (cfg.profilerEnabled && cfg.attributionEnabled) attributeLoad(cfg);
 
-                totalCallCount.store(0, std::memory_order_relaxed);
-                totalQueued.store(0, std::memory_order_relaxed);
-                totalCapped.store(0, std::memory_order_relaxed);
+            // 日志和导出共用一次采集，两边看到的是同一个周期；压测窗口内计数归压测报告
+            if ((cfg.debug || metrics.running()) && !benchmarkRunning()) {
+                auto sample = collectStats(true);
+                if (cfg.debug) {
+                    for (auto const& line : formatStats(sample)) logger().info("{}", line);
+                }
+                if (metrics.running()) metrics.submit(std::move(sample));
+            }
+
+            // 成本模型定期落盘，异常关服也不至于从零开始
+            if (cfg.costModelEnabled) {
+                auto now = std::chrono::steady_clock::now();
+                if (now - lastCostModelSave >= kCostModelSaveInterval) {
+                    lastCostModelSave = now;
+                    if (!costModel.save(costModelPath())) logger().warn("Failed to save cost model");
+                }
+            }
+
+            // 热点计数按周期减半，让旧热点逐渐让位于新热点
+            if (cfg.profilerEnabled) {
+                if (cfg.profilerJsonDump) dumpHotSpots();
+                hotSpots.decay(0.5);
             }
         }
     }).launch(ll::thread::ServerThreadExecutor::getDefault());
 }
 
+// ── 世界档案 ──────────────────────────────────────────────
+
+static constexpr size_t kProfileHotSpots = 32;
+
+static std::optional<AdaptiveController::State> warmController; // load 时读到，enable 时交给控制器
+
+// 插件 load 时 Level 还没创建，世界名取 server.properties 的 level-name；
+// 只替换文件名里不能用的 ASCII 字符，非 ASCII 的世界名原样保留
+static std::string worldName() {
+    std::ifstream file("server.properties");
+    std::string   line;
+    while (std::getline(file, line)) {
+        if (!line.starts_with("level-name=")) continue;
+        std::string name = line.substr(11);
+        while (!name.empty() && (name.back() == '\r' || name.back() == ' ')) name.pop_back();
+        for (auto& c : name) {
+            bool reserved = std::string_view("<>:\"/\\|?*").find(c) != std::string_view::npos;
+            if (static_cast<unsigned char>(c) < 0x20 || reserved) c = '_';
+        }
+        if (!name.empty()) return name;
+    }
+    return "default";
+}
+
+static std::filesystem::path worldProfilePath() {
+    static std::string const world = worldName();
+    return PluginImpl::getInstance().getSelf().getDataDir() / "profiles" / (world + ".json");
+}
+
+// policyNsPerTick 按名称对回当前的策略，成本和热点只在对应功能开着时恢复
+static void loadWorldProfile(Config const& cfg) {
+    WorldProfile profile;
+    if (!profile.load(worldProfilePath())) return;
+
+    auto now = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch());
+    auto age = now.count() - profile.savedAt;
+    if (cfg.warmStartMaxHours > 0 && age > static_cast<int64_t>(cfg.warmStartMaxHours) * 3600) {
+        logger().info("World profile is {} hours old, starting cold", age / 3600);
+        return;
+    }
+
+    for (auto const& policy : profile.policies) {
+        for (size_t i = 0; i < activePolicies.size(); ++i) {
+            if (activePolicies[i].name == policy.name) policyNsPerTick[i] = policy.nsPerTick;
+        }
+    }
+    if (cfg.costModelEnabled) costModel.restore(profile.costs);
+    if (cfg.profilerEnabled) hotSpots.restore(profile.hotSpots);
+    if (profile.controller.budget > 0) warmController = profile.controller;
+
+    logger().info(
+        "Warm start from {} | budget: {} | block costs: {} | hot spots: {}",
+        worldProfilePath().filename().string(),
+        profile.controller.budget,
+        profile.costs.size(),
+        profile.hotSpots.size()
+    );
+}
+
+static void saveWorldProfile(Config const& cfg) {
+    WorldProfile profile;
+    profile.savedAt =
+        std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    if (cfg.adaptiveBudget) profile.controller = adaptive.state();
+    for (size_t i = 0; i < activePolicies.size(); ++i) {
+        profile.policies.push_back({.name = activePolicies[i].name, .nsPerTick = policyNsPerTick[i]});
+    }
+    if (cfg.costModelEnabled) profile.costs = costModel.top(costModel.types());
+    if (cfg.profilerEnabled) profile.hotSpots = hotSpots.top(kProfileHotSpots);
+    if (!profile.save(worldProfilePath())) logger().warn("Failed to save world profile");
+}
+
 // ── 生命周期 ──────────────────────────────────────────────
 
 PluginImpl& PluginImpl::getInstance() {
@@ -186,54 +1996,133 @@ PluginImpl& PluginImpl::getInstance() {
 
 bool PluginImpl::load() {
     std::filesystem::create_directories(getSelf().getConfigDir());
+    calibrateTsc();
     if (!loadConfig()) {
         logger().warn("Failed to load config, saving defaults");
         saveConfig();
     }
+    std::error_code ec;
+    configWriteTime = std::filesystem::last_write_time(configPath(), ec);
+    publishConfig();
+
+    auto const& cfg = currentConfig();
+    if (cfg.costModelEnabled && costModel.load(costModelPath())) {
+        logger().info("Loaded cost model with {} block types", costModel.types());
+    }
+    // 世界档案在全局成本表之后读，同名类型以这个世界上学到的为准
+    if (cfg.warmStart) loadWorldProfile(cfg);
     logger().info(
-        "Loaded. budget={}(per={}, global={})",
-        config.budgetEnabled,
-        config.budgetPerTick,
-        config.globalBudgetPerTick
+        "Loaded. budget={}(per={}, global={}) policies={}",
+        cfg.budgetEnabled,
+        cfg.budgetPerTick,
+        cfg.globalBudgetPerTick,
+        activePolicies.size()
     );
     return true;
 }
 
 bool PluginImpl::enable() {
+    auto const& cfg = currentConfig();
     pluginEnabled.store(true, std::memory_order_relaxed);
 
-    totalCallCount.store(0, std::memory_order_relaxed);
-    totalQueued.store(0, std::memory_order_relaxed);
-    totalCapped.store(0, std::memory_order_relaxed);
+    threadSlots.reset();
+    leaseReturned = 0;
+    timeCappedCalls.store(0, std::memory_order_relaxed);
+    timeExhaustedTicks = 0;
     gTickBudgetRemaining.store(0, std::memory_order_relaxed);
+    gNearBudgetRemaining.store(0, std::memory_order_relaxed);
+    proximityCounters = {};
+    for (auto& tally : dimensionTallies) {
+        tally.calls.store(0, std::memory_order_relaxed);
+        tally.capped.store(0, std::memory_order_relaxed);
+        tally.processed.store(0, std::memory_order_relaxed);
+    }
+    adaptive.reset(std::max(1, cfg.globalBudgetPerTick));
+    // 热启动只用一次；计数和冷却从零开始，预算按当前配置的上下限收紧
+    if (warmController && cfg.adaptiveBudget) {
+        auto state      = *warmController;
+        int  ceiling    = std::max(cfg.adaptiveMinBudget, cfg.adaptiveMaxBudget);
+        state.budget    = std::clamp(state.budget, cfg.adaptiveMinBudget, ceiling);
+        state.increases = 0;
+        state.decreases = 0;
+        state.cooldown  = 0;
+        adaptive.restore(state);
+    }
+    warmController.reset();
 
     if (!hookInstalled.load(std::memory_order_relaxed)) {
         LevelTickHook::hook();
         PendingTicksHook::hook();
+        QueueAddHook::hook();
+        QueueRemoveHook::hook();
+        QueueDtorHook::hook();
+        ChunkSetBlockHook::hook();
+        ChunkDtorHook::hook();
         hookInstalled.store(true, std::memory_order_relaxed);
-        logger().info("Hooks installed");
+        logger().info("Hooks installed | classification scan: {}", simdLevelName(simdLevel()));
     }
 
+    syncTraceRecorder(cfg);
+    syncQueueAnalyzer(cfg);
+    syncPlaceListener(cfg);
+    registerCommand();
     startStatsTask();
     logger().info(
         "Enabled. budget={}(per={}, global={})",
-        config.budgetEnabled,
-        config.budgetPerTick,
-        config.globalBudgetPerTick
+        cfg.budgetEnabled,
+        cfg.budgetPerTick,
+        cfg.globalBudgetPerTick
     );
     return true;
 }
 
 bool PluginImpl::disable() {
+    auto const& cfg = currentConfig();
     pluginEnabled.store(false, std::memory_order_relaxed);
 
     if (hookInstalled.load(std::memory_order_relaxed)) {
         LevelTickHook::unhook();
         PendingTicksHook::unhook();
+        QueueAddHook::unhook();
+        QueueRemoveHook::unhook();
+        QueueDtorHook::unhook();
+        ChunkSetBlockHook::unhook();
+        ChunkDtorHook::unhook();
         hookInstalled.store(false, std::memory_order_relaxed);
         logger().info("Hooks uninstalled");
     }
 
+    // 要在下面清空各模块之前保存
+    if (cfg.warmStart) saveWorldProfile(cfg);
+
+    if (cfg.costModelEnabled && costModel.types() > 0 && !costModel.save(costModelPath())) {
+        logger().warn("Failed to save cost model");
+    }
+    metrics.stop();
+    tracer.stop();
+    analyzer.stop();
+    stopBenchmark();
+
+    // 卸载钩子后不再能观察到队列析构，计数必须整体作废
+    queueTracker.clear();
+    budgetPools.clear();
+    starvation.clear();
+    burst.clear();
+    coalescer.clear();
+    compactor.clear();
+    portals.clear();
+    proximity.clear();
+    hotSpots.clear();
+    if (placeListener) {
+        ll::event::EventBus::getInstance().removeListener(placeListener);
+        placeListener = nullptr;
+    }
+    attribution.clear();
+    {
+        std::lock_guard lock(deferredEvictMutex);
+        deferredEvictions.clear();
+    }
+
     logger().info("Disabled");
     return true;
 }
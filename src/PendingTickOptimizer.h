@@ -1,28 +1,214 @@
 #pragma once
+#include "StatsSample.h"
 #include <ll/api/Config.h>
 #include <ll/api/io/Logger.h>
 #include <ll/api/mod/NativeMod.h>
 #include <memory>
 #include <atomic>
+#include <string>
+#include <vector>
 
 namespace pending_tick_optimizer {
 
+// 一组方块的节流策略，按配置顺序匹配，第一个命中的策略生效
+struct ThrottlePolicy {
+    std::string              name;
+    bool                     enabled = true;
+    std::vector<std::string> blocks;
+    std::string              match               = "only"; // only：队列只含这些方块时节流；any：含任意一个即节流
+    int                      budgetPerCall       = 0;      // 单次调用最多处理 N 个计划刻，<= 0 使用 budgetPerTick
+    int                      globalBudgetPerTick = 0;      // 该策略每 tick 全服最多处理 N 个计划刻，<= 0 只受全局限制
+};
+
+// 受保护的区域，方块坐标，闭区间
+struct ProtectedArea {
+    std::string name;
+    int         dimension = 0;
+    int         minX      = 0;
+    int         minZ      = 0;
+    int         maxX      = 0;
+    int         maxZ      = 0;
+};
+
 struct Config {
-    int  version          = 1;
+    int  version          = 2; // 字段改名或删除时递增，旧文件在 migrateConfig 里迁移；新增字段缺省即可，不用递增
     bool enabled          = true;
     bool debug            = false;
     int  statsIntervalSec = 5;
+    bool watchConfig      = false; // 每个统计周期检查 config.json 的修改时间，变化时自动重载
+    bool latencyTiming    = true; // 记录 tickPendingTicks 的耗时分布，在统计输出中报告分位数
 
     bool budgetEnabled      = true;
     int  budgetPerTick      = 100; // 单次调用最多处理 N 个计划刻
-    int  globalBudgetPerTick = 300; // 每 tick 全服总计最多处理 N 个计划刻
+    int  globalBudgetPerTick = 300; // 每 tick 全服总计最多处理 N 个计划刻；time 模式下为微秒数
+
+    // count：按计划刻数计预算；time：globalBudgetPerTick 为每 tick 的处理时间（微秒），
+    // 计数预算退为 budgetSafetyLimit 这一道硬上限
+    std::string budgetMode        = "count";
+    int         budgetSafetyLimit = 2000;
+
+    // 最多同时启用 8 个策略
+    std::vector<ThrottlePolicy> policies = {
+        {
+            .name   = "portal",
+            .blocks = {"minecraft:portal", "minecraft:end_portal", "minecraft:end_gateway"},
+        },
+        {
+            .name    = "redstone",
+            .enabled = false,
+            .blocks =
+                {"minecraft:redstone_wire",
+                 "minecraft:unpowered_repeater",
+                 "minecraft:powered_repeater",
+                 "minecraft:unpowered_comparator",
+                 "minecraft:powered_comparator",
+                 "minecraft:redstone_torch",
+                 "minecraft:unlit_redstone_torch",
+                 "minecraft:observer"},
+            .match               = "any",
+            .budgetPerCall       = 64,
+            .globalBudgetPerTick = 512,
+        },
+        {
+            .name    = "fluid",
+            .enabled = false,
+            .blocks =
+                {"minecraft:water", "minecraft:flowing_water", "minecraft:lava", "minecraft:flowing_lava"},
+            .budgetPerCall       = 64,
+            .globalBudgetPerTick = 512,
+        },
+        {
+            .name                = "falling",
+            .enabled             = false,
+            .blocks              = {"minecraft:sand", "minecraft:red_sand", "minecraft:gravel", "minecraft:scaffolding"},
+            .budgetPerCall       = 32,
+            .globalBudgetPerTick = 256,
+        },
+    };
+
+    // 分级预算：全局 → 维度 → 区域，<= 0 表示该级不限
+    // 默认不限，只由全局预算封顶；设了之后实际上限是三级中最紧的那一级
+    int  dimensionBudgetPerTick = 0;    // 每 tick 每个维度最多处理 N 个计划刻
+    int  areaBudgetPerTick      = 0;    // 每 tick 每个区域最多处理 N 个计划刻
+    int  areaChunkShift         = 2;    // 区域边长为 2^N 个区块
+    bool budgetRollover         = true; // 已 tick 完的维度剩余额度让给之后的维度
+
+    // 预算租约：每个线程一次从全局预算租一批额度，计数按线程分槽，tick 结束时收回剩余
+    // 开启后服务器线程以外的 tickPendingTicks 调用也受全局预算约束（不分策略），从各自的租约里取，不与服务器线程争用
+    // 关闭时所有线程直接读写共享的全局预算和计数，其它线程上的调用直接放行
+    bool budgetLeasing   = false;
+    int  budgetLeaseSize = 32; // 每次续租的最小额度
+
+    // 玩家附近和保护区域内的区块优先：为其预留一部分全局预算，远处区块只能用剩下的
+    bool                       proximityPriority = false;
+    int                        nearChunkRadius   = 8;  // 距在线玩家 N 个区块以内视为附近
+    int                        nearReservePct    = 40; // 每 tick 为附近区块预留的全局预算百分比
+    std::vector<ProtectedArea> protectedAreas    = {};
+
+    int starvationReservePct = 30; // 每 tick 按饥饿时长优先预留给被限流队列的全局预算百分比
+    int maxStarvationTicks   = 20; // 连续被限流超过 N tick 的队列强制放行一次，<= 0 不强制
+
+    // 后台预分析：出队后仍需全量扫描或合并扫描的队列，把元数据拷给工作线程分析，下一 tick 直接用结果
+    bool backgroundAnalysis    = false;
+    int  analysisMinQueue      = 256; // 队列至少有 N 个计划刻才交给后台，短队列内联扫描更快
+    int  analysisMaxStaleTicks = 2;   // 结果最多晚 N tick 仍可用，超出或队列长度已变就回退到内联扫描
+
+    // 突发控制：命中策略的队列各有一个令牌桶；首次见到就有大量积压的队列（区块刚加载）把积压摊到若干 tick 里
+    bool burstLimiting      = false;
+    int  burstCapacity      = 512;  // 令牌桶容量，即单个队列一次最多吃下的突发
+    int  burstRefillPerTick = 64;   // 每 tick 补充的令牌，决定稳态上限
+    bool backlogSmoothing   = false; // 同样只作用于命中策略的队列，未命中的原版刻照常放行
+    int  backlogThreshold   = 1024; // 首次见到时积压达到 N 才平滑
+    int  backlogSmoothTicks = 40;   // 积压均摊到的 tick 数
+
+    // 自适应预算：按 Level::tick 实测耗时用 AIMD 调整 globalBudgetPerTick
+    bool   adaptiveBudget    = false;
+    double targetMspt        = 45.0; // 目标每 tick 耗时（毫秒）
+    double adaptiveHeadroom  = 0.8;  // 平滑 MSPT 低于 target * headroom 时才加预算
+    int    adaptiveIncrease  = 10;   // 有余量时每 tick 增加的预算
+    double adaptiveDecrease  = 0.5;  // 超时时预算乘以该系数
+    int    adaptiveCooldown  = 5;    // 两次削减之间至少间隔的 tick 数
+    int    adaptiveMinBudget = 50;
+    int    adaptiveMaxBudget = 2000;
+
+    // 成本模型：按方块类型学习单刻耗时，预算按成本单位扣除，学到的表保存在 cost_model.json
+    bool   costModelEnabled = false;
+    double costUnitNs       = 2000.0; // 1 个成本单位对应的单刻耗时（纳秒）
+    double costMinWeight    = 0.25;   // 单刻最少按 N 个单位计
+    double costMaxWeight    = 8.0;    // 单刻最多按 N 个单位计
+
+    // 重复计划刻合并：同一位置同一方块只保留最早的一条，仅对列出的幂等方块生效
+    bool                     coalesceEnabled  = false;
+    std::vector<std::string> coalesceBlocks   = {"minecraft:portal"};
+    int                      coalesceMinQueue = 32; // 队列至少有 N 个计划刻才尝试合并
+    int                      coalesceInterval = 20; // 同一队列两次合并之间至少间隔 N tick
+
+    // 传送门刻抑制：邻域（按区块）自上次校验以来没有方块变化时，传送门不再排校验刻
+    bool                     portalSuppression = false;
+    std::vector<std::string> portalBlocks      = {"minecraft:portal", "minecraft:end_gateway"};
+    int                      portalWatchRadius = 2; // 邻域半径（区块），要覆盖最大的框架（23 格）
+
+    // 墓碑压缩：mIsRemoved 占比过高的队列去掉墓碑后重建堆
+    bool   compactionEnabled  = false;
+    double compactionRatio    = 0.5; // 墓碑占比达到此值才重建
+    int    compactionMinDead  = 64;  // 墓碑数达到 N 才重建
+    int    compactionBudgetUs = 200; // 每 tick 用于重建的时间上限（微秒）
+
+    // 热点分析：按区块采样统计 tickPendingTicks 的耗时
+    bool profilerEnabled    = false;
+    int  profilerSampleRate = 16;    // 每 N 次调用采样一次
+    int  profilerCapacity   = 64;    // 最多跟踪 N 个热点区块，内存固定
+    int  profilerLogTop     = 5;     // 统计输出中打印前 N 个热点
+    bool profilerJsonDump   = false; // 每个统计周期把全部热点写入 hotspots.json
+
+    // 负载归属：每个统计周期把热点区块记到最后在那里放置方块的玩家，或附近最近的玩家名下，需开启 profilerEnabled
+    bool   attributionEnabled     = false;
+    int    attributionWindowTicks = 12000; // 放置记录的有效期，过期后按附近玩家归属
+    int    attributionRadius      = 4;     // 没有放置记录时，归给 N 个区块以内最近的在线玩家
+    double attributionFlagMs      = 50.0;  // 名下热点耗时（与热点报告同口径）达到此值即标记，回落到一半以下解除
+    int    attributionLogTop      = 3;     // 统计输出中打印前 N 个玩家
+    // 惩罚档：被标记玩家名下的热点区块里命中策略的队列不用附近预留，每次调用的需求压到 attributionPenaltyPct%；
+    // 未命中策略的原版刻（作物、门、策略之外的流体）不受影响
+    bool attributionPenalty    = false;
+    int  attributionPenaltyPct = 25;
+
+    // 指标导出：每个统计周期追加一行 metrics.jsonl，并重写 Prometheus textfile，均在后台线程完成
+    bool        metricsEnabled        = false;
+    bool        metricsJsonl          = true;
+    bool        metricsPrometheus     = true;
+    std::string metricsPrometheusPath = ""; // 为空则写到数据目录的 metrics.prom
+    int         metricsMaxFileMb      = 64; // metrics.jsonl 超过后轮转为 .1，0 不限
+
+    // trace 录制：把每次 tickPendingTicks 录进数据目录 traces/ 下的二进制文件，供 pto-replay 离线回放
+    bool traceEnabled    = false;
+    int  traceBufferSize = 65536; // 环形缓冲的记录数，写盘跟不上时丢弃新记录
+
+    // 热启动：disable 时把控制器状态、学到的成本和热点写进数据目录 profiles/<世界名>.json，下次 load 时读回
+    bool warmStart         = true;
+    int  warmStartMaxHours = 72; // 档案超过 N 小时不再使用，0 不限
 };
 
+// getConfig 返回编辑副本，修改后需要 publishConfig 才会生效；运行时读取一律用 currentConfig 快照
 Config&         getConfig();
+Config const&   currentConfig();
 bool            loadConfig();
 bool            saveConfig();
+void            publishConfig();
+bool            reloadConfig(); // 重新读取 config.json 并发布，失败时保留当前配置
 ll::io::Logger& logger();
 
+// 统计报告，每个元素一行；reset 为 true 时同时清零本周期计数（统计协程），命令查看时不清零
+std::vector<std::string> statsReport(bool reset);
+StatsSample              collectStats(bool reset); // 同一份数据的结构化形式，导出和压测报告使用
+std::vector<std::string> budgetReport();
+std::vector<std::string> policyReport();
+std::vector<std::string> traceReport();
+
+// 热点：前 count 个的文本，或全部写入数据目录下的 hotspots.json
+std::vector<std::string> hotSpotReport(size_t count);
+bool                     dumpHotSpots();
+void                     resetHotSpots();
+
 class PluginImpl {
 public:
     static PluginImpl& getInstance();
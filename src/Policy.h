@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdint>
+
+namespace pending_tick_optimizer {
+
+// 同时生效的节流策略上限，每个策略在方块分类掩码里占一位
+inline constexpr int kMaxPolicies = 8;
+
+enum class PolicyMatch : uint8_t {
+    Only, // 队列里只有这些方块时节流
+    Any,  // 队列里含有任意一个这些方块时节流
+};
+
+} // namespace pending_tick_optimizer
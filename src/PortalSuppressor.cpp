@@ -0,0 +1,96 @@
+#include "PortalSuppressor.h"
+#include "ChunkKey.h"
+#include <algorithm>
+#include <utility>
+
+namespace pending_tick_optimizer {
+
+void PortalSuppressor::setRadius(int chunks) {
+    chunks = std::clamp(chunks, 0, 4);
+    if (chunks == mRadius) return;
+    clear();
+    mRadius = chunks;
+}
+
+void PortalSuppressor::onBlockChanged(int dimension, int chunkX, int chunkZ) {
+    if (mWatched.size() == 0) return;
+    if (auto* watch = mWatched.find(packChunkKey(dimension, chunkX, chunkZ))) watch->lastChange = ++mGeneration;
+}
+
+bool PortalSuppressor::suppress(void const* queue, int dimension, int chunkX, int chunkZ) {
+    auto* portal = mPortals.find(queue);
+    if (!portal) {
+        // 第一次见到的传送门区块先放行，出队后才算校验过
+        Portal fresh{.dimension = dimension, .chunkX = chunkX, .chunkZ = chunkZ};
+        watch(fresh, true);
+        mPortals[queue] = fresh;
+        ++mCounters.allowed;
+        return false;
+    }
+    if (!portal->validated) {
+        ++mCounters.allowed;
+        return false;
+    }
+    if (portal->checkedAt != mGeneration) {
+        if (latestChange(*portal) > portal->validatedAt) {
+            portal->validated = false;
+            ++mCounters.invalidations;
+            ++mCounters.allowed;
+            return false;
+        }
+        portal->checkedAt = mGeneration;
+    }
+    ++mCounters.suppressed;
+    return true;
+}
+
+void PortalSuppressor::onDrained(void const* queue) {
+    auto* portal = mPortals.find(queue);
+    if (!portal) return;
+    // 变化引起的计划刻在变化的同一次 setBlock 里就排进去了，早于这次出队，
+    // 所以出队之后的新计划刻都是在新邻域下排的，可以据此确认
+    portal->validated   = true;
+    portal->validatedAt = mGeneration;
+    portal->checkedAt   = mGeneration;
+}
+
+void PortalSuppressor::evict(void const* queue) {
+    auto* portal = mPortals.find(queue);
+    if (!portal) return;
+    watch(*portal, false);
+    mPortals.erase(queue);
+}
+
+void PortalSuppressor::clear() {
+    mPortals.clear();
+    mWatched.clear();
+    mCounters = {};
+}
+
+PortalSuppressor::Counters PortalSuppressor::takeCounters() { return std::exchange(mCounters, {}); }
+
+void PortalSuppressor::watch(Portal const& portal, bool add) {
+    for (int dx = -mRadius; dx <= mRadius; ++dx) {
+        for (int dz = -mRadius; dz <= mRadius; ++dz) {
+            uint64_t key = packChunkKey(portal.dimension, portal.chunkX + dx, portal.chunkZ + dz);
+            if (add) {
+                ++mWatched[key].refs;
+            } else if (auto* watch = mWatched.find(key); watch && --watch->refs == 0) {
+                mWatched.erase(key);
+            }
+        }
+    }
+}
+
+uint32_t PortalSuppressor::latestChange(Portal const& portal) noexcept {
+    uint32_t latest = 0;
+    for (int dx = -mRadius; dx <= mRadius; ++dx) {
+        for (int dz = -mRadius; dz <= mRadius; ++dz) {
+            auto* watch = mWatched.find(packChunkKey(portal.dimension, portal.chunkX + dx, portal.chunkZ + dz));
+            if (watch) latest = std::max(latest, watch->lastChange);
+        }
+    }
+    return latest;
+}
+
+} // namespace pending_tick_optimizer
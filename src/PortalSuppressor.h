@@ -0,0 +1,73 @@
+#pragma once
+#include "FlatMap.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace pending_tick_optimizer {
+
+// 传送门刻抑制：传送门方块的计划刻大多只是重新检查框架，结构没变就什么也不做
+// 每个含传送门的队列（即区块）记一个"最近校验时"的代数，只有其邻域内的方块变化才推进代数；
+// 邻域自上次校验以来没变时，新的传送门计划刻直接不排，变化后放行，由原版逻辑做一次真正的校验
+// 邻域按区块计，半径要覆盖最大的框架；非线程安全，只在服务器线程上调用
+class PortalSuppressor {
+public:
+    struct Counters {
+        uint64_t suppressed    = 0; // 没有排进队列的计划刻
+        uint64_t allowed       = 0; // 因未校验或邻域变化而放行的计划刻
+        uint64_t invalidations = 0; // 邻域变化使校验失效的次数
+    };
+
+    // 半径变化时已有记录全部作废
+    void setRadius(int chunks);
+
+    // 被监视的区块里有方块变化时推进代数，其余区块直接忽略
+    void onBlockChanged(int dimension, int chunkX, int chunkZ);
+
+    // 传送门方块要排计划刻时调用，返回 true 表示可以不排
+    bool suppress(void const* queue, int dimension, int chunkX, int chunkZ);
+
+    // 队列出队后调用：其中到期的传送门刻已按当前邻域跑过
+    void onDrained(void const* queue);
+
+    [[nodiscard]] bool tracks(void const* queue) noexcept { return mPortals.find(queue) != nullptr; }
+
+    void evict(void const* queue);
+    void clear();
+    void shrink() {
+        mPortals.shrinkToFit();
+        mWatched.shrinkToFit();
+    }
+
+    [[nodiscard]] size_t memoryUsage() const noexcept { return mPortals.memoryUsage() + mWatched.memoryUsage(); }
+
+    [[nodiscard]] size_t          portals() const noexcept { return mPortals.size(); }
+    [[nodiscard]] size_t          watched() const noexcept { return mWatched.size(); }
+    [[nodiscard]] Counters        takeCounters();
+    [[nodiscard]] Counters const& counters() const noexcept { return mCounters; }
+
+private:
+    struct Portal {
+        int      dimension   = 0;
+        int      chunkX      = 0;
+        int      chunkZ      = 0;
+        bool     validated   = false;
+        uint32_t validatedAt = 0; // 最近一次校验时的代数
+        uint32_t checkedAt   = 0; // 最近一次确认邻域未变时的代数，相等说明之后没有任何被监视的变化
+    };
+
+    struct Watch {
+        uint32_t lastChange = 0;
+        uint32_t refs       = 0; // 有多少个传送门区块的邻域包含它
+    };
+
+    void                   watch(Portal const& portal, bool add);
+    [[nodiscard]] uint32_t latestChange(Portal const& portal) noexcept;
+
+    int                          mRadius     = 2;
+    uint32_t                     mGeneration = 1;
+    FlatMap<void const*, Portal> mPortals;
+    FlatMap<uint64_t, Watch>     mWatched;
+    Counters                     mCounters;
+};
+
+} // namespace pending_tick_optimizer
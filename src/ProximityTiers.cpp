@@ -0,0 +1,60 @@
+#include "ProximityTiers.h"
+#include "ChunkKey.h"
+#include <algorithm>
+
+namespace pending_tick_optimizer {
+
+void ProximityTiers::setRadius(int chunks) {
+    chunks = std::max(0, chunks);
+    if (chunks == mRadius) return;
+    mRadius = chunks;
+    rebuild();
+}
+
+void ProximityTiers::endSnapshot() {
+    // 快照排序后比较，玩家顺序变化不触发重建
+    std::sort(mPending.begin(), mPending.end(), [](PlayerChunk const& a, PlayerChunk const& b) {
+        if (a.dimension != b.dimension) return a.dimension < b.dimension;
+        if (a.chunkX != b.chunkX) return a.chunkX < b.chunkX;
+        return a.chunkZ < b.chunkZ;
+    });
+    mPending.erase(std::unique(mPending.begin(), mPending.end()), mPending.end());
+    if (mPending == mPlayers) return;
+    mPlayers.swap(mPending);
+    rebuild();
+}
+
+void ProximityTiers::rebuild() {
+    mCells.clear();
+    for (auto const& player : mPlayers) {
+        int minX = (player.chunkX - mRadius) >> kCellShift;
+        int maxX = (player.chunkX + mRadius) >> kCellShift;
+        int minZ = (player.chunkZ - mRadius) >> kCellShift;
+        int maxZ = (player.chunkZ + mRadius) >> kCellShift;
+        for (int x = minX; x <= maxX; ++x) {
+            for (int z = minZ; z <= maxZ; ++z) mCells[packChunkKey(player.dimension, x, z)] = 1;
+        }
+    }
+}
+
+ProximityTiers::Tier ProximityTiers::tierOf(int dimension, int chunkX, int chunkZ) const {
+    if (!mPlayers.empty()
+        && mCells.find(packChunkKey(dimension, chunkX >> kCellShift, chunkZ >> kCellShift))) {
+        return Tier::Near;
+    }
+    for (auto const& area : mAreas) {
+        if (area.dimension == dimension && chunkX >= area.minChunkX && chunkX <= area.maxChunkX
+            && chunkZ >= area.minChunkZ && chunkZ <= area.maxChunkZ) {
+            return Tier::Near;
+        }
+    }
+    return Tier::Far;
+}
+
+void ProximityTiers::clear() {
+    mPlayers.clear();
+    mPending.clear();
+    mCells.clear();
+}
+
+} // namespace pending_tick_optimizer
@@ -0,0 +1,68 @@
+#pragma once
+#include "FlatMap.h"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace pending_tick_optimizer {
+
+// 区块到优先级的映射：在线玩家附近或保护区域内的区块为 Near，其余为 Far
+// 玩家位置每 tick 快照一次，只有玩家所在区块集合变化时才重建网格
+// 网格以 2^kCellShift 个区块为一格，半径按格向外取整，判定结果是精确半径的超集
+// 非线程安全，只在服务器线程上调用
+class ProximityTiers {
+public:
+    static constexpr int kCellShift = 2;
+
+    enum class Tier : uint8_t { Near, Far };
+
+    // 闭区间，区块坐标
+    struct Area {
+        int dimension = 0;
+        int minChunkX = 0;
+        int minChunkZ = 0;
+        int maxChunkX = 0;
+        int maxChunkZ = 0;
+    };
+
+    void setAreas(std::vector<Area> areas) { mAreas = std::move(areas); }
+    void setRadius(int chunks);
+
+    // 每 tick：beginSnapshot → 对每个玩家 addPlayer → endSnapshot
+    void beginSnapshot() { mPending.clear(); }
+    void addPlayer(int dimension, int chunkX, int chunkZ) { mPending.push_back({dimension, chunkX, chunkZ}); }
+    void endSnapshot();
+
+    [[nodiscard]] Tier tierOf(int dimension, int chunkX, int chunkZ) const;
+
+    // 没有玩家也没有保护区域时，为 Near 预留预算没有意义
+    [[nodiscard]] bool   hasNearTargets() const noexcept { return !mPlayers.empty() || !mAreas.empty(); }
+    [[nodiscard]] size_t players() const noexcept { return mPlayers.size(); }
+    [[nodiscard]] size_t nearCells() const noexcept { return mCells.size(); }
+    [[nodiscard]] size_t memoryUsage() const noexcept {
+        return mCells.memoryUsage() + (mAreas.capacity() * sizeof(Area))
+             + (mPlayers.capacity() + mPending.capacity()) * sizeof(PlayerChunk);
+    }
+
+    void clear();
+
+private:
+    struct PlayerChunk {
+        int dimension;
+        int chunkX;
+        int chunkZ;
+
+        bool operator==(PlayerChunk const&) const = default;
+    };
+
+    void rebuild();
+
+    int                      mRadius = 8;
+    std::vector<Area>        mAreas;
+    std::vector<PlayerChunk> mPlayers;
+    std::vector<PlayerChunk> mPending;
+    // 玩家附近的网格格子，键同 packChunkKey；FlatMap::find 不是 const
+    mutable FlatMap<uint64_t, uint8_t> mCells;
+};
+
+} // namespace pending_tick_optimizer
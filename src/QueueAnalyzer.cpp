@@ -0,0 +1,180 @@
+#include "QueueAnalyzer.h"
+#include "TickCoalescer.h"
+#include <utility>
+
+namespace pending_tick_optimizer {
+
+void QueueAnalyzer::start(TypeNameFn typeNameOf) {
+    if (running()) return;
+    mTypeNameOf     = typeNameOf;
+    mStopping       = false;
+    mBusy           = false;
+    mDone           = false;
+    mWorkGeneration = 0;
+    mThread         = std::thread([this] { run(); });
+}
+
+void QueueAnalyzer::stop() {
+    if (!running()) return;
+    {
+        std::lock_guard lock(mMutex);
+        mStopping = true;
+    }
+    mWake.notify_one();
+    mThread.join();
+    mWork.reset();
+    mBusy = false;
+    mDone = false;
+    clear();
+}
+
+void QueueAnalyzer::setPolicies(
+    std::vector<std::vector<std::string>> const& policyBlocks,
+    std::vector<std::string> const&              coalesceBlocks
+) {
+    // 换代之后，在途批次的结果在 beginTick 里被丢弃
+    ++mGeneration;
+    mResults.clear();
+    mPending.reset();
+    mCaptured.clear();
+    std::lock_guard lock(mMutex);
+    mPolicyBlocks   = policyBlocks;
+    mCoalesceBlocks = coalesceBlocks;
+}
+
+void QueueAnalyzer::beginTick() {
+    std::lock_guard lock(mMutex);
+    if (!mDone) return;
+    mResults.clear();
+    if (mWork.generation == mGeneration) {
+        for (auto const& [queue, result] : mWork.results) {
+            if (!mEvicted.find(queue)) mResults[queue] = result;
+        }
+    }
+    mEvicted.clear();
+    mWork.reset();
+    mBusy = false;
+    mDone = false;
+}
+
+void QueueAnalyzer::endTick() {
+    mCaptured.clear();
+    if (mPending.spans.empty()) return;
+    {
+        std::lock_guard lock(mMutex);
+        if (mBusy) {
+            // 工作线程跟不上时宁可丢掉这一批，下一 tick 这些队列回退到内联扫描
+            ++mCounters.dropped;
+            mPending.reset();
+            return;
+        }
+        std::swap(mWork, mPending);
+        mWork.generation = mGeneration;
+        mBusy            = true;
+    }
+    mPending.reset();
+    mWake.notify_one();
+}
+
+QueueAnalyzer::Result const* QueueAnalyzer::lookup(void const* queue, size_t size, uint32_t now, uint32_t maxStale) {
+    auto* result = mResults.find(queue);
+    if (!result) return nullptr;
+    if (now - result->tick > maxStale || result->size != size) {
+        ++mCounters.stale;
+        mResults.erase(queue);
+        return nullptr;
+    }
+    ++mCounters.hits;
+    return result;
+}
+
+void QueueAnalyzer::invalidate(void const* queue) {
+    mResults.erase(queue);
+    // 本 tick 的拷贝作废，之后同一 tick 里还可以重新拷一份
+    if (auto* index = mCaptured.find(queue)) {
+        mPending.spans[*index - 1].queue = nullptr;
+        mCaptured.erase(queue);
+    }
+    // mBusy 只由服务器线程写，这里读不需要加锁；没有在途批次时 mEvicted 保持为空
+    if (mBusy) mEvicted[queue] = 1;
+}
+
+void QueueAnalyzer::clear() {
+    ++mGeneration;
+    mResults.clear();
+    mPending.reset();
+    mCaptured.clear();
+    mEvicted.clear();
+    mCounters = {};
+}
+
+QueueAnalyzer::Counters QueueAnalyzer::takeCounters() {
+    Counters counters = mCounters;
+    mCounters         = {};
+    return counters;
+}
+
+// ── 工作线程 ──────────────────────────────────────────────
+
+void QueueAnalyzer::run() {
+    std::unique_lock lock(mMutex);
+    while (true) {
+        mWake.wait(lock, [this] { return mStopping || (mBusy && !mDone); });
+        if (mStopping) return;
+        if (mWork.generation != mWorkGeneration) {
+            mPolicyClassifier.setPolicies(mPolicyBlocks);
+            mCoalesceClassifier.setPolicies({mCoalesceBlocks});
+            mWorkGeneration = mWork.generation;
+        }
+        // mBusy 期间服务器线程不碰 mWork
+        lock.unlock();
+        analyze(mWork);
+        lock.lock();
+        mDone = true;
+    }
+}
+
+void QueueAnalyzer::analyze(Batch& batch) {
+    batch.results.reserve(batch.spans.size());
+    for (auto const& span : batch.spans) {
+        if (!span.queue) continue; // 交出之前已作废
+        Entry const* begin = batch.entries.data() + span.offset;
+        Result       result = analyzeSpan(begin, begin + span.size);
+        result.tick         = span.tick;
+        result.size         = span.size;
+        batch.results.emplace_back(span.queue, result);
+    }
+}
+
+QueueAnalyzer::Result QueueAnalyzer::analyzeSpan(Entry const* begin, Entry const* end) {
+    Result result;
+    for (Entry const* entry = begin; entry != end; ++entry) {
+        if (entry->removed) {
+            ++result.dead;
+            continue;
+        }
+        if (!entry->block) continue;
+        ++result.live;
+        void const* block  = entry->block;
+        auto        nameOf = [this, block]() -> std::string const& { return mTypeNameOf(block); };
+        uint32_t    mask   = mPolicyClassifier.classify(block, nameOf);
+        for (int i = 0; i < kMaxPolicies; ++i) {
+            if ((mask >> i) & 1u) ++result.members[i];
+        }
+        if (mCoalesceClassifier.classify(block, nameOf) == 0) continue;
+
+        // Entry 的 x / y / z 字段与 BlockPos 同名，直接当位置用
+        auto& slot = mFirst[TickCoalescer::keyOf(*entry, block)];
+        if (slot == 0) {
+            slot = static_cast<uint32_t>(entry - begin + 1);
+            continue;
+        }
+        // 键是散列出来的，核对位置和方块
+        Entry const& kept = begin[slot - 1];
+        if (kept.block == block && TickCoalescer::samePos(kept, *entry)) ++result.duplicates;
+    }
+    mFirst.clear();
+    return result;
+}
+
+} // namespace pending_tick_optimizer
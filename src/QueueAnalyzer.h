@@ -0,0 +1,162 @@
+#pragma once
+#include "BlockClassifier.h"
+#include "FlatMap.h"
+#include "Policy.h"
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pending_tick_optimizer {
+
+// 队列预分析：tick N 里出队后还需要全量扫描的队列，服务器线程只拷一份只读的元数据（方块指针、位置、墓碑），
+// tick 末交给工作线程做策略分类、重复刻和墓碑计数；tick N+1 开始时把结果换进来，钩子里一次查表取用
+// 结果带快照时的 tick 和队列长度，超过时限或长度对不上就不用，调用方回退到内联扫描
+// capture / beginTick / endTick / lookup 只在服务器线程上调用
+class QueueAnalyzer {
+public:
+    // 工作线程上解析方块类型名；Block 在注册表初始化后不再修改，只读访问不需要同步
+    using TypeNameFn = std::string const& (*)(void const* block);
+
+    struct Result {
+        uint32_t                           tick       = 0; // 快照所在的 tick
+        uint32_t                           size       = 0; // 快照时的 mC.size()
+        uint32_t                           live       = 0; // 存活的刻数
+        uint32_t                           dead       = 0; // 墓碑数
+        uint32_t                           duplicates = 0; // 可合并方块里同位置的重复刻数
+        std::array<uint32_t, kMaxPolicies> members{};      // 属于各策略方块集合的存活刻数
+    };
+
+    struct Counters {
+        uint64_t captured        = 0; // 交给后台的队列数
+        uint64_t hits            = 0; // 用上了后台结果的查询
+        uint64_t stale           = 0; // 有结果但过期或长度不符，回退到内联扫描
+        uint64_t dropped         = 0; // 后台还没处理完上一批，本批丢弃
+        uint64_t coalesceSkipped = 0; // 后台确认没有重复刻，跳过的合并扫描
+    };
+
+    QueueAnalyzer() = default;
+    QueueAnalyzer(QueueAnalyzer const&)            = delete;
+    QueueAnalyzer& operator=(QueueAnalyzer const&) = delete;
+    ~QueueAnalyzer() { stop(); }
+
+    void start(TypeNameFn typeNameOf);
+    void stop();
+
+    [[nodiscard]] bool running() const noexcept { return mThread.joinable(); }
+
+    // 策略变化后已发布和在途的结果全部作废
+    void setPolicies(std::vector<std::vector<std::string>> const& policyBlocks, std::vector<std::string> const& coalesceBlocks);
+
+    // ticks 为 BlockTick 序列，只读
+    template <class Ticks>
+    void capture(void const* queue, Ticks const& ticks, uint32_t tick) {
+        if (mCaptured.find(queue)) return;
+        mCaptured[queue] = static_cast<uint32_t>(mPending.spans.size() + 1);
+        Span span{.queue = queue, .offset = mPending.entries.size(), .tick = tick, .size = static_cast<uint32_t>(ticks.size())};
+        for (auto const& entry : ticks) {
+            auto const& pos = entry.mData.mPos;
+            mPending.entries.push_back({
+                .block   = entry.mData.mBlock,
+                .x       = pos.x,
+                .y       = pos.y,
+                .z       = pos.z,
+                .removed = entry.mIsRemoved,
+            });
+        }
+        mPending.spans.push_back(span);
+        ++mCounters.captured;
+    }
+
+    // tick 开始：换入后台已完成的结果；tick 结束：把本 tick 的快照交出去
+    void beginTick();
+    void endTick();
+
+    // 结果过期（now - tick > maxStale）或长度不符时返回 nullptr
+    [[nodiscard]] Result const* lookup(void const* queue, size_t size, uint32_t now, uint32_t maxStale);
+
+    void onCoalesceSkipped() noexcept { ++mCounters.coalesceSkipped; }
+
+    // 结果已被用掉
+    void discard(void const* queue) { mResults.erase(queue); }
+
+    // 队列被改动（打了墓碑，长度不变所以 lookup 认不出来）：已发布的结果、本 tick 的拷贝和在途批次里的快照都作废
+    void invalidate(void const* queue);
+    // 队列析构，同 invalidate
+    void evict(void const* queue) { invalidate(queue); }
+    void clear();
+
+    [[nodiscard]] size_t results() const noexcept { return mResults.size(); }
+    // 只算服务器线程一侧：结果表和本 tick 的拷贝缓冲；在途批次与之大小相当
+    [[nodiscard]] size_t memoryUsage() const noexcept {
+        return mResults.memoryUsage() + mCaptured.memoryUsage() + mEvicted.memoryUsage()
+             + mPending.entries.capacity() * sizeof(Entry) + mPending.spans.capacity() * sizeof(Span);
+    }
+    [[nodiscard]] Counters        takeCounters();
+    [[nodiscard]] Counters const& counters() const noexcept { return mCounters; }
+
+private:
+    struct Entry {
+        void const* block   = nullptr;
+        int         x       = 0;
+        int         y       = 0;
+        int         z       = 0;
+        bool        removed = false;
+    };
+
+    struct Span {
+        void const* queue  = nullptr;
+        size_t      offset = 0;
+        uint32_t    tick   = 0;
+        uint32_t    size   = 0;
+    };
+
+    struct Batch {
+        std::vector<Entry>                               entries;
+        std::vector<Span>                                spans;
+        std::vector<std::pair<void const*, Result>>      results;
+        uint32_t                                         generation = 0;
+
+        void reset() {
+            entries.clear();
+            spans.clear();
+            results.clear();
+        }
+    };
+
+    void   run();
+    void   analyze(Batch& batch);
+    Result analyzeSpan(Entry const* begin, Entry const* end);
+
+    // 服务器线程
+    Batch                        mPending;
+    FlatMap<void const*, uint32_t> mCaptured; // 本 tick 已拷贝的队列 → mPending.spans 下标 + 1
+    FlatMap<void const*, Result>   mResults;
+    FlatMap<void const*, char>     mEvicted; // 在途批次交出之后被改动或析构的队列，换入时跳过
+    Counters                     mCounters;
+    uint32_t                     mGeneration = 1;
+
+    // 工作线程与交接区，mMutex 保护
+    TypeNameFn                            mTypeNameOf = nullptr;
+    std::thread                           mThread;
+    std::mutex                            mMutex;
+    std::condition_variable               mWake;
+    Batch                                 mWork;
+    bool                                  mBusy     = false; // mWork 已交给工作线程且尚未完成
+    bool                                  mDone     = false; // mWork.results 可以取走
+    bool                                  mStopping = false;
+    std::vector<std::vector<std::string>> mPolicyBlocks;
+    std::vector<std::string>              mCoalesceBlocks;
+    uint32_t                              mWorkGeneration = 0; // 工作线程分类器对应的策略版本
+
+    // 只在工作线程上访问
+    BlockClassifier             mPolicyClassifier;
+    BlockClassifier             mCoalesceClassifier;
+    FlatMap<uint64_t, uint32_t> mFirst; // (位置, 方块) → 条目下标 + 1，复用缓冲
+};
+
+} // namespace pending_tick_optimizer
@@ -0,0 +1,140 @@
+#include "QueueTracker.h"
+#include <algorithm>
+
+namespace pending_tick_optimizer {
+
+void QueueTracker::setPolicies(std::vector<PolicyMatch> const& modes) {
+    mPolicyCount = static_cast<int>(std::min<size_t>(modes.size(), kMaxPolicies));
+    for (int i = 0; i < mPolicyCount; ++i) mModes[i] = modes[i];
+    mStates.clear();
+}
+
+QueueState& QueueTracker::beginScan(void const* queue) {
+    auto& state = mStates[queue];
+    state       = QueueState{};
+    return state;
+}
+
+void QueueTracker::endScan(QueueState& state, size_t size, uint32_t stamp) noexcept {
+    state.knownSize = static_cast<uint32_t>(size);
+    state.scanStamp = stamp;
+    state.lastSeen  = stamp;
+    int verdict     = decide(state, size);
+    state.verdict   = static_cast<int8_t>(verdict == kUnknown ? -1 : verdict);
+}
+
+QueueState& QueueTracker::adopt(
+    void const*                               queue,
+    uint32_t                                  live,
+    std::array<uint32_t, kMaxPolicies> const& members,
+    size_t                                    size,
+    uint32_t                                  stamp
+) {
+    auto& state = beginScan(queue);
+    for (int i = 0; i < mPolicyCount; ++i) {
+        uint32_t count  = mModes[i] == PolicyMatch::Only ? live - members[i] : members[i];
+        state.counts[i] = {.lo = count, .hi = count};
+    }
+    endScan(state, size, stamp);
+    return state;
+}
+
+void QueueTracker::onAdd(void const* queue, uint32_t policyMask, size_t sizeAfter, bool draining) {
+    auto* state = mStates.find(queue);
+    if (!state || state->knownSize == kInvalidSize) return;
+    if (draining) {
+        // 出队和入队交错，knownSize 保持出队前的值；新刻先计入上界，onDrained 按 adds 结算出队数
+        for (int i = 0; i < mPolicyCount; ++i) {
+            if (counts(i, policyMask)) ++state->counts[i].hi;
+        }
+        return;
+    }
+    // 只有恰好多了一条才能确定是这次 add 带来的，否则计数作废，下次 tick 全量扫描
+    if (sizeAfter != static_cast<size_t>(state->knownSize) + 1) {
+        state->knownSize = kInvalidSize;
+        return;
+    }
+    for (int i = 0; i < mPolicyCount; ++i) {
+        if (counts(i, policyMask)) {
+            ++state->counts[i].lo;
+            ++state->counts[i].hi;
+        }
+    }
+    state->knownSize = static_cast<uint32_t>(sizeAfter);
+}
+
+void QueueTracker::onRemove(void const* queue, uint32_t policyMask) {
+    auto* state = mStates.find(queue);
+    if (!state) return;
+    // remove 只打 mIsRemoved 标记，不确定是否真的命中了存活的刻，只能放宽下界
+    for (int i = 0; i < mPolicyCount; ++i) {
+        if (counts(i, policyMask) && state->counts[i].lo > 0) --state->counts[i].lo;
+    }
+}
+
+void QueueTracker::onDrained(void const* queue, size_t sizeAfter, size_t adds) {
+    auto* state = mStates.find(queue);
+    if (!state || state->knownSize == kInvalidSize) return;
+    if (sizeAfter == 0) {
+        state->counts    = {};
+        state->knownSize = 0;
+        return;
+    }
+    size_t total = static_cast<size_t>(state->knownSize) + adds;
+    if (sizeAfter > total) {
+        // 出现了未记录的入队，计数作废
+        state->knownSize = kInvalidSize;
+        return;
+    }
+    auto popped = static_cast<uint32_t>(total - sizeAfter);
+    auto size   = static_cast<uint32_t>(sizeAfter);
+    for (int i = 0; i < mPolicyCount; ++i) {
+        auto& bounds = state->counts[i];
+        bounds.lo   -= std::min(bounds.lo, popped);
+        bounds.hi    = std::min(bounds.hi, size);
+    }
+    state->knownSize = size;
+}
+
+void QueueTracker::onCompacted(void const* queue, size_t sizeBefore, size_t sizeAfter) {
+    auto* state = mStates.find(queue);
+    if (!state || state->knownSize == kInvalidSize) return;
+    if (state->knownSize != sizeBefore) {
+        state->knownSize = kInvalidSize;
+        return;
+    }
+    auto size = static_cast<uint32_t>(sizeAfter);
+    for (int i = 0; i < mPolicyCount; ++i) {
+        auto& bounds = state->counts[i];
+        bounds.hi    = std::min(bounds.hi, size);
+    }
+    state->knownSize = size;
+}
+
+size_t QueueTracker::collectIdle(uint32_t now, uint32_t idleTicks, void const** out, size_t capacity) {
+    size_t count = 0;
+    mStates.forEach([&](void const* queue, QueueState const& state) {
+        if (count < capacity && now - state.lastSeen > idleTicks) out[count++] = queue;
+    });
+    return count;
+}
+
+int QueueTracker::decide(QueueState const& state, size_t size) const noexcept {
+    if (state.knownSize != size) return kUnknown;
+    if (size == 0) return -1;
+    // 按配置顺序，第一个确定命中的策略生效；前面的策略无法判断时不能跳过
+    for (int i = 0; i < mPolicyCount; ++i) {
+        auto const& bounds = state.counts[i];
+        if (mModes[i] == PolicyMatch::Only) {
+            if (bounds.hi == 0) return i;
+            if (bounds.lo > 0) continue;
+        } else {
+            if (bounds.lo > 0) return i;
+            if (bounds.hi == 0) continue;
+        }
+        return kUnknown;
+    }
+    return -1;
+}
+
+} // namespace pending_tick_optimizer
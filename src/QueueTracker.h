@@ -0,0 +1,86 @@
+#pragma once
+#include "FlatMap.h"
+#include "Policy.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pending_tick_optimizer {
+
+// 计数的上下界。出队发生在原函数内部无法逐条观察，只能按大小变化收紧边界
+struct CountBounds {
+    uint32_t lo = 0;
+    uint32_t hi = 0;
+};
+
+// 单个 BlockTickingQueue 的增量计数
+// Only 策略记录“存活且不属于该策略”的刻数，Any 策略记录“存活且属于该策略”的刻数，
+// 这样两种匹配方式都只需要判断一个计数是否为零
+struct QueueState {
+    std::array<CountBounds, kMaxPolicies> counts{};
+    uint32_t                              knownSize = 0; // 最近一次观察到的 mC.size()，不一致说明有未挂钩的修改路径
+    uint32_t                              scanStamp = 0; // 最近一次全量扫描的 tick
+    uint32_t                              lastSeen  = 0; // 最近一次被 tick 的 tick，长期不动的队列会被清扫
+    int8_t                                verdict   = -1; // 最近一次全量扫描得出的策略下标，-1 表示放行
+};
+
+class QueueTracker {
+public:
+    static constexpr uint32_t kInvalidSize = UINT32_MAX;
+    static constexpr int      kUnknown     = -2;
+
+    void setPolicies(std::vector<PolicyMatch> const& modes);
+
+    [[nodiscard]] QueueState* find(void const* queue) noexcept { return mStates.find(queue); }
+
+    // 全量扫描的结果：live 为存活刻数，members[i] 为其中属于第 i 个策略的刻数
+    // 内联扫描（按类型 id 列计数）和后台分析都经这里重建计数
+    QueueState& adopt(
+        void const*                               queue,
+        uint32_t                                  live,
+        std::array<uint32_t, kMaxPolicies> const& members,
+        size_t                                    size,
+        uint32_t                                  stamp
+    );
+
+    // add / remove 钩子：只更新已跟踪的队列，未跟踪的队列在下次 tick 时全量扫描
+    // draining 表示 add 发生在该队列自己的 tickPendingTicks 里（重新排刻），此时大小对不上，留到 onDrained 一起结算
+    void onAdd(void const* queue, uint32_t policyMask, size_t sizeAfter, bool draining);
+    void onRemove(void const* queue, uint32_t policyMask);
+
+    // tickPendingTicks 返回后调用，按大小变化加上期间新增的 adds 条推算出队数
+    void onDrained(void const* queue, size_t sizeAfter, size_t adds);
+
+    // 墓碑压缩后调用：存活刻一条不少，只有大小变了
+    void onCompacted(void const* queue, size_t sizeBefore, size_t sizeAfter);
+
+    void evict(void const* queue) { mStates.erase(queue); }
+    void clear() { mStates.clear(); }
+    void shrink() { mStates.shrinkToFit(); }
+
+    // 把超过 idleTicks 没被 tick 的队列写进 out（至多 capacity 个），返回个数；不在这里删除，
+    // 由调用方走统一的驱逐路径，连同其它模块的状态一起清掉
+    size_t collectIdle(uint32_t now, uint32_t idleTicks, void const** out, size_t capacity);
+
+    [[nodiscard]] size_t size() const noexcept { return mStates.size(); }
+    [[nodiscard]] size_t memoryUsage() const noexcept { return mStates.memoryUsage(); }
+
+    // 返回命中的策略下标，-1 放行，kUnknown 表示计数不足以判断、需要全量扫描
+    [[nodiscard]] int decide(QueueState const& state, size_t size) const noexcept;
+
+private:
+    QueueState& beginScan(void const* queue);
+    void        endScan(QueueState& state, size_t size, uint32_t stamp) noexcept;
+
+    [[nodiscard]] bool counts(int policy, uint32_t policyMask) const noexcept {
+        bool member = (policyMask >> policy) & 1u;
+        return mModes[policy] == PolicyMatch::Only ? !member : member;
+    }
+
+    std::array<PolicyMatch, kMaxPolicies> mModes{};
+    int                                   mPolicyCount = 0;
+    FlatMap<void const*, QueueState>      mStates;
+};
+
+} // namespace pending_tick_optimizer
@@ -0,0 +1,79 @@
+#include "StarvationScheduler.h"
+#include <algorithm>
+
+namespace pending_tick_optimizer {
+
+int StarvationScheduler::beginTick(Settings const& settings, TickArena& arena) {
+    mSettings = settings;
+    ++mStamp;
+
+    // 上个 tick 没有再被限流的队列（已被服务、已清空或已卸载）不再算饥饿
+    uint32_t now = mStamp;
+    mEntries.eraseIf([now](void const*, Entry const& entry) { return now - entry.stamp > 1; });
+
+    Ranked* order = arena.allocate<Ranked>(mEntries.size());
+    size_t  count = 0;
+    mEntries.forEach([order, &count](void const* queue, Entry& entry) {
+        entry.reserved = 0;
+        order[count++] = {.age = entry.age, .queue = queue};
+    });
+    std::sort(order, order + count, [](Ranked const& a, Ranked const& b) { return a.age > b.age; });
+
+    int left = std::max(0, settings.reserveBudget);
+    for (size_t i = 0; i < count; ++i) {
+        if (left <= 0) break;
+        auto* entry     = mEntries.find(order[i].queue);
+        entry->reserved = std::min(entry->want, left);
+        left           -= entry->reserved;
+    }
+    int reserved        = std::max(0, settings.reserveBudget) - left;
+    mCounters.reserved += static_cast<uint64_t>(reserved);
+    return reserved;
+}
+
+StarvationScheduler::Claim StarvationScheduler::claim(void const* queue, int want) {
+    auto* entry = mEntries.find(queue);
+    if (!entry) return {};
+    if (mSettings.maxStarvationTicks > 0 && entry->age >= static_cast<uint32_t>(mSettings.maxStarvationTicks)) {
+        // 超过最坏延迟上限，不管预算是否够都放行一次；强制放行不占预留，预留原样交还
+        ++mCounters.forced;
+        int released    = entry->reserved;
+        entry->reserved = 0;
+        return {.granted = want, .released = released, .forced = true};
+    }
+    int granted     = std::min(entry->reserved, want);
+    int released    = entry->reserved - granted;
+    entry->reserved = 0;
+    return {.granted = granted, .released = released};
+}
+
+int StarvationScheduler::evict(void const* queue) {
+    auto* entry = mEntries.find(queue);
+    if (!entry) return 0;
+    int reserved = entry->reserved;
+    mEntries.erase(queue);
+    return reserved;
+}
+
+void StarvationScheduler::onCapped(void const* queue, int want) {
+    auto& entry = mEntries[queue];
+    if (entry.stamp != mStamp) {
+        entry.age   = entry.stamp + 1 == mStamp ? entry.age + 1 : 1;
+        entry.stamp = mStamp;
+    }
+    entry.want       = want;
+    mCounters.maxAge = std::max(mCounters.maxAge, entry.age);
+}
+
+void StarvationScheduler::clear() {
+    mEntries.clear();
+    mCounters = {};
+}
+
+StarvationScheduler::Counters StarvationScheduler::takeCounters() {
+    Counters counters = mCounters;
+    mCounters         = {};
+    return counters;
+}
+
+} // namespace pending_tick_optimizer
@@ -0,0 +1,68 @@
+#pragma once
+#include "FlatMap.h"
+#include "TickArena.h"
+#include <cstdint>
+
+namespace pending_tick_optimizer {
+
+// 记录被限流的队列及其连续饥饿的 tick 数
+// 每个 tick 开始时按饥饿时间从长到短，从全局预算里预留额度；
+// 饥饿超过上限的队列直接强制放行，保证任何受限刻的最坏延迟有界
+class StarvationScheduler {
+public:
+    struct Settings {
+        int reserveBudget      = 0; // 本 tick 可用于预留的预算总量
+        int maxStarvationTicks = 0; // <= 0 表示不强制放行
+    };
+
+    struct Counters {
+        uint32_t maxAge   = 0; // 本统计周期内观察到的最大饥饿 tick 数
+        uint64_t reserved = 0; // 预留出去的额度
+        uint64_t forced   = 0; // 强制放行的次数
+    };
+
+    // 返回本 tick 实际预留的总量，调用方需要从全局预算中扣掉；排序缓冲从本 tick 的 arena 里切
+    int beginTick(Settings const& settings, TickArena& arena);
+
+    struct Claim {
+        int  granted  = 0;     // 0 表示走普通预算路径
+        int  released = 0;     // 预留了但这次用不上的部分，调用方退回全局预算
+        bool forced   = false; // 强制放行的额度不来自全局预算，用不完也不能退回
+    };
+
+    // 队列被调用时先来认领预留额度；预留只在本 tick 有效，认领之后剩下的当场交还
+    Claim claim(void const* queue, int want);
+
+    void onCapped(void const* queue, int want);
+    void onServed(void const* queue) { mEntries.erase(queue); }
+    // 返回该队列本 tick 尚未认领的预留，调用方退回全局预算（区块卸载时队列不会再来认领）
+    int evict(void const* queue);
+    void clear();
+    void shrink() { mEntries.shrinkToFit(); }
+
+    [[nodiscard]] size_t memoryUsage() const noexcept { return mEntries.memoryUsage(); }
+
+    [[nodiscard]] size_t          starving() const noexcept { return mEntries.size(); }
+    [[nodiscard]] Counters        takeCounters();
+    [[nodiscard]] Counters const& counters() const noexcept { return mCounters; }
+
+private:
+    struct Entry {
+        uint32_t age      = 0;
+        uint32_t stamp    = 0; // 最近一次被限流的 tick
+        int      want     = 0;
+        int      reserved = 0;
+    };
+
+    struct Ranked {
+        uint32_t    age;
+        void const* queue;
+    };
+
+    Settings                    mSettings;
+    uint32_t                    mStamp = 0;
+    FlatMap<void const*, Entry> mEntries;
+    Counters                    mCounters;
+};
+
+} // namespace pending_tick_optimizer
@@ -0,0 +1,139 @@
+#pragma once
+#include "AdaptiveController.h"
+#include "BudgetPools.h"
+#include "BurstLimiter.h"
+#include "CostModel.h"
+#include "HotSpotTracker.h"
+#include "LatencyHistogram.h"
+#include "LoadAttribution.h"
+#include "PortalSuppressor.h"
+#include "QueueAnalyzer.h"
+#include "StarvationScheduler.h"
+#include "TombstoneCompactor.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pending_tick_optimizer {
+
+// 一个统计周期的快照：计数是本周期的增量，其余是采样时刻的瞬时值
+// 在服务器线程上一次性采集，之后只读，可以交给其它线程格式化或导出
+struct StatsSample {
+    struct Policy {
+        std::string name;
+        uint64_t    calls     = 0;
+        uint64_t    queued    = 0;
+        uint64_t    capped    = 0;
+        uint64_t    processed = 0;
+    };
+
+    struct Dimension {
+        int      dimension = 0;
+        uint64_t calls     = 0;
+        uint64_t capped    = 0;
+        uint64_t processed = 0;
+    };
+
+    int64_t  timestampMs = 0;
+    uint32_t serverTick  = 0;
+
+    std::vector<Policy>    policies;
+    std::vector<Dimension> dimensions; // 只含本周期有调用的维度
+
+    bool                      latencyTiming = false;
+    LatencyHistogram::Summary throttledUs;
+    LatencyHistogram::Summary passThroughUs;
+    LatencyHistogram::Summary tickMs; // Level::tick 耗时，即 MSPT 分布
+
+    size_t trackedQueues = 0;
+    size_t cachedBlocks  = 0;
+
+    // 插件自身的内存占用（字节），按模块分组
+    struct MemoryUsage {
+        size_t queues      = 0; // 增量计数、合并、墓碑、传送门
+        size_t scheduling  = 0; // 饥饿调度、令牌桶
+        size_t analysis    = 0; // 后台预分析（服务器线程一侧）
+        size_t classifiers = 0; // 方块分类缓存、类型 id
+        size_t profiling   = 0; // 热点、成本模型、trace
+        size_t pools       = 0; // 区域预算池、玩家附近网格
+        size_t total       = 0; // 以上加 arena
+    };
+
+    MemoryUsage memory;
+    uint64_t    sweptQueues            = 0; // 长期没被 tick 而被清扫的队列
+    size_t      arenaBytes             = 0;
+    size_t   arenaPeak              = 0; // 单个 tick 用到的最大字节数
+    uint64_t arenaOverflows         = 0; // arena 追加块的次数，稳态应为 0
+    bool     allocTracking          = false;
+    uint64_t hotPathTicks           = 0;
+    uint64_t hotPathAllocatingTicks = 0;
+    uint64_t hotPathAllocations     = 0;
+
+    bool                    analysis = false;
+    QueueAnalyzer::Counters analysisCounters;
+    size_t                  analysisResults = 0;
+
+    int                   globalBudget = 0;
+    BudgetPools::Counters pools;
+    size_t                trackedAreas = 0;
+
+    StarvationScheduler::Counters starvation;
+    size_t                        starvingQueues = 0;
+
+    bool                   burst = false;
+    BurstLimiter::Counters burstCounters;
+    size_t                 burstQueues = 0;
+
+    bool                      adaptive = false;
+    AdaptiveController::State adaptiveState;
+    double                    targetMspt = 0.0;
+
+    bool     timeSliced         = false;
+    uint64_t timeExhaustedTicks = 0;
+    uint64_t timeCappedCalls    = 0;
+
+    bool     coalesce       = false;
+    uint64_t merged         = 0;
+    size_t   coalesceQueues = 0;
+
+    bool                       portal = false;
+    PortalSuppressor::Counters portalCounters;
+    size_t                     portalChunks  = 0;
+    size_t                     portalWatched = 0;
+
+    bool                         compaction = false;
+    TombstoneCompactor::Counters compacted;
+    size_t                       compactionPending = 0;
+
+    bool     leasing       = false;
+    int      leaseThreads  = 0;
+    uint64_t leaseRefills  = 0;
+    uint64_t leaseReturned = 0;
+    uint64_t offThreadCalls     = 0;
+    uint64_t offThreadCapped    = 0;
+    uint64_t offThreadProcessed = 0;
+
+    bool     proximity   = false;
+    size_t   players     = 0;
+    size_t   nearCells   = 0;
+    uint64_t nearCalls   = 0;
+    uint64_t farCalls    = 0;
+    uint64_t reserveUsed = 0;
+
+    bool                             costModel = false;
+    CostModel::Settings              costSettings;
+    std::vector<CostModel::TypeCost> costTop;
+
+    bool                               profiler = false;
+    std::vector<HotSpotTracker::Entry> hotSpots;
+
+    bool                                     attribution = false;
+    bool                                     penalty     = false;
+    LoadAttribution::Counters                attributionCounters;
+    size_t                                   flaggedPlayers  = 0;
+    size_t                                   penalizedChunks = 0;
+    size_t                                   placements      = 0;
+    std::vector<LoadAttribution::PlayerLoad> attributedPlayers;
+};
+
+} // namespace pending_tick_optimizer
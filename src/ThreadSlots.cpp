@@ -0,0 +1,60 @@
+#include "ThreadSlots.h"
+#include <algorithm>
+#include <vector>
+
+namespace pending_tick_optimizer {
+
+namespace {
+
+struct LocalIndex {
+    uint64_t owner;
+    int      index;
+};
+
+// 实例编号不复用，析构后新建的实例不会认领旧实例的槽位
+std::atomic<uint64_t> nextInstanceId{1};
+// 本线程在各个实例里分到的槽位，实例通常只有一两个，线性查找即可
+thread_local std::vector<LocalIndex> localIndices;
+
+} // namespace
+
+ThreadSlots::ThreadSlots() noexcept : mId(nextInstanceId.fetch_add(1, std::memory_order_relaxed)) {}
+
+ThreadSlot& ThreadSlots::local(bool perThread) noexcept {
+    if (!perThread) return mSlots[0];
+    for (auto const& entry : localIndices) {
+        if (entry.owner == mId) return mSlots[entry.index];
+    }
+    // 超出槽数的线程按取模共享槽位，仍然正确，只是会重新出现争用
+    int n     = mNext.fetch_add(1, std::memory_order_relaxed);
+    int index = n < kMaxThreadSlots ? n : 1 + (n - 1) % (kMaxThreadSlots - 1);
+    localIndices.push_back({mId, index});
+    return mSlots[index];
+}
+
+int ThreadSlots::reclaimLeases() noexcept {
+    int total = 0;
+    forEach([&total](ThreadSlot& slot) { total += slot.lease.exchange(0, std::memory_order_relaxed); });
+    return total;
+}
+
+void ThreadSlots::reset() noexcept {
+    auto clearTally = [](PolicyTally& tally) {
+        tally.calls.store(0, std::memory_order_relaxed);
+        tally.queued.store(0, std::memory_order_relaxed);
+        tally.capped.store(0, std::memory_order_relaxed);
+        tally.processed.store(0, std::memory_order_relaxed);
+    };
+    for (auto& slot : mSlots) {
+        for (auto& tally : slot.policies) clearTally(tally);
+        clearTally(slot.offThread);
+        slot.lease.store(0, std::memory_order_relaxed);
+        slot.refills.store(0, std::memory_order_relaxed);
+    }
+}
+
+int ThreadSlots::threads() const noexcept {
+    return std::min(mNext.load(std::memory_order_relaxed), kMaxThreadSlots) - 1;
+}
+
+} // namespace pending_tick_optimizer
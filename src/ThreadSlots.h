@@ -0,0 +1,87 @@
+#pragma once
+#include "Policy.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace pending_tick_optimizer {
+
+inline constexpr size_t kCacheLineSize  = 64;
+inline constexpr int    kMaxThreadSlots = 32;
+
+struct PolicyTally {
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> queued{0};
+    std::atomic<uint64_t> capped{0};
+    std::atomic<uint64_t> processed{0};
+};
+
+// 每个线程独占一个按缓存行对齐的槽：统计计数和从全局预算租来的额度
+// 槽内原子量只有所属线程高频写入，统计协程和 tick 结束时的回收偶尔读写
+struct alignas(kCacheLineSize) ThreadSlot {
+    std::array<PolicyTally, kMaxPolicies> policies{};
+    PolicyTally                           offThread{}; // 服务器线程以外的调用，不分策略
+    std::atomic<int>                      lease{0};   // 剩余租约，为负表示欠下的追加扣除
+    std::atomic<uint64_t>                 refills{0}; // 从全局预算续租的次数
+};
+
+// 从一个共享预算里尽量取出 want，返回实际取到的量
+inline int takeBudget(std::atomic<int>& budget, int want) noexcept {
+    int remaining = budget.load(std::memory_order_relaxed);
+    int taken     = std::min(want, remaining);
+    while (remaining > 0
+           && !budget.compare_exchange_weak(
+               remaining,
+               remaining - taken,
+               std::memory_order_relaxed,
+               std::memory_order_relaxed
+           )) {
+        taken = std::min(want, remaining);
+    }
+    return remaining > 0 ? taken : 0;
+}
+
+// 先从本线程槽的租约里取，不足时从共享预算一次性续租 max(leaseSize, 缺口)
+inline int takeLeased(ThreadSlot& slot, std::atomic<int>& shared, int want, int leaseSize) noexcept {
+    int granted = takeBudget(slot.lease, want);
+    if (granted < want) {
+        int refill = takeBudget(shared, std::max(leaseSize, want - granted));
+        if (refill > 0) {
+            slot.lease.fetch_add(refill, std::memory_order_relaxed);
+            slot.refills.fetch_add(1, std::memory_order_relaxed);
+            granted += takeBudget(slot.lease, want - granted);
+        }
+    }
+    return granted;
+}
+
+class ThreadSlots {
+public:
+    ThreadSlots() noexcept;
+
+    // perThread 为 false 时所有线程共用 0 号槽，行为等同于原先的共享计数
+    [[nodiscard]] ThreadSlot& local(bool perThread) noexcept;
+
+    template <class Fn>
+    void forEach(Fn&& fn) {
+        int used = std::min(mNext.load(std::memory_order_relaxed), kMaxThreadSlots);
+        for (int i = 0; i < used; ++i) fn(mSlots[i]);
+    }
+
+    // 收回所有线程的剩余租约，返回总量（可能为负）
+    int reclaimLeases() noexcept;
+
+    // 清零所有计数和租约，不回收槽位分配
+    void reset() noexcept;
+
+    [[nodiscard]] int threads() const noexcept;
+
+private:
+    std::array<ThreadSlot, kMaxThreadSlots> mSlots;
+    std::atomic<int>                        mNext{1}; // 0 号槽保留给共享模式
+    uint64_t                                mId;      // 区分实例，线程记住的槽位按实例查
+};
+
+} // namespace pending_tick_optimizer
@@ -0,0 +1,48 @@
+#include "TickArena.h"
+#include <algorithm>
+#include <utility>
+
+namespace pending_tick_optimizer {
+
+void* TickArena::allocate(size_t bytes, size_t align) {
+    if (mBlocks.empty()) grow(std::max(mInitialBytes, bytes + align));
+    auto* base    = mBlocks.back().data.get();
+    auto  address = reinterpret_cast<uintptr_t>(base) + mOffset;
+    auto  aligned = (address + align - 1) & ~static_cast<uintptr_t>(align - 1);
+    if (aligned + bytes > reinterpret_cast<uintptr_t>(base) + mBlocks.back().size) {
+        ++mOverflows;
+        grow(std::max(mBlocks.back().size * 2, bytes + align));
+        base    = mBlocks.back().data.get();
+        address = reinterpret_cast<uintptr_t>(base);
+        aligned = (address + align - 1) & ~static_cast<uintptr_t>(align - 1);
+    }
+    mOffset  = static_cast<size_t>(aligned - reinterpret_cast<uintptr_t>(base)) + bytes;
+    mUsed   += bytes;
+    return reinterpret_cast<void*>(aligned);
+}
+
+void TickArena::reset() {
+    mHighWater = std::max(mHighWater, mUsed);
+    mUsed      = 0;
+    mOffset    = 0;
+    if (mBlocks.size() <= 1) return;
+    // 上个 tick 溢出过：合并成一块，下次同样的用量一块就装得下
+    size_t total = capacity();
+    mBlocks.clear();
+    grow(total);
+}
+
+size_t TickArena::capacity() const noexcept {
+    size_t total = 0;
+    for (auto const& block : mBlocks) total += block.size;
+    return total;
+}
+
+uint64_t TickArena::takeOverflows() noexcept { return std::exchange(mOverflows, 0); }
+
+void TickArena::grow(size_t atLeast) {
+    mBlocks.push_back({.data = std::make_unique_for_overwrite<std::byte[]>(atLeast), .size = atLeast});
+    mOffset = 0;
+}
+
+} // namespace pending_tick_optimizer
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace pending_tick_optimizer {
+
+// 每 tick 的单调分配区：tick 开始时整体 reset，tick 内的临时缓冲都从这里切，用完不逐个释放
+// 当前块不够时追加一块并记一次溢出；reset 时把所有块合并成一整块，学到峰值后稳态 tick 不再碰堆
+// 切出的内存不调用析构，只能放平凡析构的类型；非线程安全，只在服务器线程上使用
+class TickArena {
+public:
+    static constexpr size_t kDefaultBytes = 256 * 1024;
+
+    explicit TickArena(size_t initialBytes = kDefaultBytes) : mInitialBytes(initialBytes) {}
+    TickArena(TickArena const&)            = delete;
+    TickArena& operator=(TickArena const&) = delete;
+
+    [[nodiscard]] void* allocate(size_t bytes, size_t align);
+
+    // 未初始化的 count 个 T，由调用方构造
+    template <class T>
+    [[nodiscard]] T* allocate(size_t count) {
+        static_assert(std::is_trivially_destructible_v<T>, "arena memory is reclaimed without running destructors");
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void reset();
+
+    [[nodiscard]] size_t   used() const noexcept { return mUsed; }
+    [[nodiscard]] size_t   highWater() const noexcept { return mHighWater; }
+    [[nodiscard]] size_t   capacity() const noexcept;
+    [[nodiscard]] uint64_t overflows() const noexcept { return mOverflows; }
+    [[nodiscard]] uint64_t takeOverflows() noexcept;
+
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> data;
+        size_t                       size = 0;
+    };
+
+    void grow(size_t atLeast);
+
+    size_t             mInitialBytes;
+    std::vector<Block> mBlocks;
+    size_t             mOffset    = 0; // 在最后一块里的偏移
+    size_t             mUsed      = 0; // 本 tick 切出的总字节
+    size_t             mHighWater = 0; // 历史上单个 tick 用到的最大字节数
+    uint64_t           mOverflows = 0;
+};
+
+} // namespace pending_tick_optimizer
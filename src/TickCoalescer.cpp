@@ -0,0 +1,31 @@
+#include "TickCoalescer.h"
+#include <utility>
+
+namespace pending_tick_optimizer {
+
+bool TickCoalescer::due(void const* queue, size_t size, uint32_t now, Settings const& settings) {
+    if (size < settings.minQueueSize || size < 2) return false;
+    if (auto* last = mLastRun.find(queue)) {
+        if (now - *last < settings.intervalTicks) return false;
+        *last = now;
+        return true;
+    }
+    mLastRun[queue] = now;
+    return true;
+}
+
+bool TickCoalescer::wouldRun(void const* queue, size_t size, uint32_t now, Settings const& settings) {
+    if (size < settings.minQueueSize || size < 2) return false;
+    auto* last = mLastRun.find(queue);
+    return !last || now - *last >= settings.intervalTicks;
+}
+
+void TickCoalescer::clear() {
+    mLastRun.clear();
+    mFirst.clear();
+    mMerged = 0;
+}
+
+uint64_t TickCoalescer::takeMerged() noexcept { return std::exchange(mMerged, 0); }
+
+} // namespace pending_tick_optimizer
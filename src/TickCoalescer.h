@@ -0,0 +1,97 @@
+#pragma once
+#include "FlatMap.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace pending_tick_optimizer {
+
+// 合并同一位置、同一方块的重复计划刻：只保留最先出队的一条（tickID 最小，其次 priorityOffset 最小），
+// 其余打上 mIsRemoved 墓碑，由原函数出队时跳过
+// 保留的正是堆顶方向的那一条，不改动任何排序键，堆性质保持不变
+// 只对配置里声明为幂等的方块使用，非线程安全，只在服务器线程上调用
+class TickCoalescer {
+public:
+    struct Settings {
+        uint32_t minQueueSize  = 0; // 队列短于此值不值得扫描
+        uint32_t intervalTicks = 0; // 同一队列两次合并之间至少间隔的 tick 数
+    };
+
+    // 判断该队列本 tick 是否需要合并，返回 true 时已记下本次时间
+    bool due(void const* queue, size_t size, uint32_t now, Settings const& settings);
+    // 同样的判断但不记时间，用来预判下一 tick 是否会合并
+    bool wouldRun(void const* queue, size_t size, uint32_t now, Settings const& settings);
+
+    // ticks 为 BlockTick 序列；isCoalescable(block) 判断方块是否幂等；
+    // onMerged(block) 在每条被打墓碑的刻上调用。返回本次合并掉的条数
+    template <class Ticks, class IsCoalescable, class OnMerged>
+    size_t coalesce(Ticks& ticks, IsCoalescable&& isCoalescable, OnMerged&& onMerged) {
+        size_t merged = 0;
+        for (size_t i = 0; i < ticks.size(); ++i) {
+            auto& entry = ticks[i];
+            if (entry.mIsRemoved || !entry.mData.mBlock) continue;
+            if (!isCoalescable(entry.mData.mBlock)) continue;
+
+            auto& slot = mFirst[keyOf(entry.mData.mPos, entry.mData.mBlock)];
+            if (slot == 0) {
+                slot = static_cast<uint32_t>(i + 1);
+                continue;
+            }
+            auto& kept = ticks[slot - 1];
+            // 键是散列出来的，真正合并前核对位置和方块
+            if (kept.mData.mBlock != entry.mData.mBlock || !samePos(kept.mData.mPos, entry.mData.mPos)) continue;
+
+            if (earlier(entry.mData, kept.mData)) {
+                kept.mIsRemoved = true;
+                onMerged(kept.mData.mBlock);
+                slot = static_cast<uint32_t>(i + 1);
+            } else {
+                entry.mIsRemoved = true;
+                onMerged(entry.mData.mBlock);
+            }
+            ++merged;
+        }
+        mFirst.clear();
+        mMerged += merged;
+        return merged;
+    }
+
+    void evict(void const* queue) { mLastRun.erase(queue); }
+    void clear();
+    // 只归还按队列记录的 mLastRun；mFirst 是每次合并的临时表，clear 后保留容量，稳态下不碰堆
+    void shrink() { mLastRun.shrinkToFit(); }
+
+    [[nodiscard]] size_t memoryUsage() const noexcept { return mLastRun.memoryUsage() + mFirst.memoryUsage(); }
+
+    [[nodiscard]] size_t   trackedQueues() const noexcept { return mLastRun.size(); }
+    [[nodiscard]] uint64_t takeMerged() noexcept;
+    [[nodiscard]] uint64_t merged() const noexcept { return mMerged; }
+
+    // (位置, 方块) 的散列键与核对；后台预分析数重复刻时用同一套，两边对"重复"的判断不会分歧
+    template <class Pos>
+    static uint64_t keyOf(Pos const& pos, void const* block) noexcept {
+        uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(pos.x) & 0x3ffffffu) << 38)
+                     | (static_cast<uint64_t>(static_cast<uint32_t>(pos.y) & 0xfffu) << 26)
+                     | (static_cast<uint64_t>(static_cast<uint32_t>(pos.z) & 0x3ffffffu));
+        key ^= static_cast<uint64_t>(reinterpret_cast<uintptr_t>(block)) * 0x9e3779b97f4a7c15ULL;
+        return key != 0 ? key : 1;
+    }
+
+    template <class Pos>
+    static bool samePos(Pos const& a, Pos const& b) noexcept {
+        return a.x == b.x && a.y == b.y && a.z == b.z;
+    }
+
+private:
+
+    template <class Data>
+    static bool earlier(Data const& a, Data const& b) noexcept {
+        if (a.mTick.tickID != b.mTick.tickID) return a.mTick.tickID < b.mTick.tickID;
+        return a.mPriorityOffset < b.mPriorityOffset;
+    }
+
+    FlatMap<void const*, uint32_t> mLastRun; // 队列 → 上次合并的 tick
+    FlatMap<uint64_t, uint32_t>    mFirst;   // 扫描期间 (位置, 方块) → 保留条目的下标 + 1，复用缓冲
+    uint64_t                       mMerged = 0;
+};
+
+} // namespace pending_tick_optimizer
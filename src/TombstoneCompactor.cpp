@@ -0,0 +1,38 @@
+#include "TombstoneCompactor.h"
+#include <utility>
+
+namespace pending_tick_optimizer {
+
+void TombstoneCompactor::beginTick(Settings const& settings) {
+    mSettings = settings;
+    mSpentNs  = 0;
+}
+
+void TombstoneCompactor::observe(void const* queue, size_t dead) {
+    if (dead == 0) {
+        mDead.erase(queue);
+    } else {
+        mDead[queue] = static_cast<uint32_t>(dead);
+    }
+}
+
+bool TombstoneCompactor::due(void const* queue, size_t size) {
+    auto* dead = mDead.find(queue);
+    if (!dead || *dead < mSettings.minDead) return false;
+    if (static_cast<double>(*dead) < mSettings.ratio * static_cast<double>(size)) return false;
+    if (mSpentNs >= mSettings.budgetNs) {
+        ++mCounters.deferred;
+        return false;
+    }
+    return true;
+}
+
+void TombstoneCompactor::clear() {
+    mDead.clear();
+    mCounters = {};
+    mSpentNs  = 0;
+}
+
+TombstoneCompactor::Counters TombstoneCompactor::takeCounters() noexcept { return std::exchange(mCounters, {}); }
+
+} // namespace pending_tick_optimizer
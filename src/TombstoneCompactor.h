@@ -0,0 +1,88 @@
+#pragma once
+#include "FlatMap.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace pending_tick_optimizer {
+
+// 清理 TickDataSet 堆里的 mIsRemoved 墓碑
+// 墓碑数只是估计：全量扫描给出准确值，remove / 合并时累加，出队时无法扣减；
+// 估计值超过阈值的队列在下一次被 tick 时按准确计数决定是否重建
+// 单个队列的重建必须一次完成（两次 tick 之间游戏会改动堆），跨 tick 分摊的是队列，每 tick 有时间上限
+// 非线程安全，只在服务器线程上调用
+class TombstoneCompactor {
+public:
+    struct Settings {
+        double   ratio    = 0.5; // 墓碑占比达到此值才重建
+        uint32_t minDead  = 0;   // 墓碑数达到此值才重建
+        uint64_t budgetNs = 0;   // 每 tick 用于重建的时间上限
+    };
+
+    struct Counters {
+        uint64_t queues    = 0; // 重建过的队列数
+        uint64_t removed   = 0; // 删除的墓碑数
+        uint64_t reclaimed = 0; // 删掉的墓碑占用的字节
+        uint64_t released  = 0; // shrink_to_fit 归还的容量字节
+        uint64_t deferred  = 0; // 因本 tick 时间用完而推迟的次数
+    };
+
+    void beginTick(Settings const& settings);
+
+    // 全量扫描得到的准确墓碑数
+    void observe(void const* queue, size_t dead);
+    // remove / 合并新打的墓碑
+    void onTombstoned(void const* queue, size_t count) { mDead[queue] += static_cast<uint32_t>(count); }
+
+    // 估计值是否值得一次准确检查；本 tick 时间已用完时推迟
+    bool due(void const* queue, size_t size);
+
+    // 重新计数并在达标时重建堆，later(a, b) 为 true 表示 a 应排在 b 之后（与游戏的小顶堆一致）
+    // 返回删除的墓碑数
+    template <class Ticks, class Later>
+    size_t compact(void const* queue, Ticks& ticks, Later&& later) {
+        size_t dead = 0;
+        for (auto const& entry : ticks) dead += entry.mIsRemoved ? 1 : 0;
+        if (dead < mSettings.minDead || static_cast<double>(dead) < mSettings.ratio * static_cast<double>(ticks.size())) {
+            observe(queue, dead);
+            return 0;
+        }
+
+        size_t capacityBefore = ticks.capacity();
+        ticks.erase(
+            std::remove_if(ticks.begin(), ticks.end(), [](auto const& entry) { return entry.mIsRemoved; }),
+            ticks.end()
+        );
+        std::make_heap(ticks.begin(), ticks.end(), later);
+        // 长期积压后容量可能远大于存活刻数，归还一部分
+        if (ticks.capacity() > ticks.size() * 4) ticks.shrink_to_fit();
+
+        using Entry = typename Ticks::value_type;
+        mCounters.queues    += 1;
+        mCounters.removed   += dead;
+        mCounters.reclaimed += dead * sizeof(Entry);
+        mCounters.released  += (capacityBefore - std::min(capacityBefore, ticks.capacity())) * sizeof(Entry);
+        mDead.erase(queue);
+        return dead;
+    }
+
+    void charge(uint64_t ns) noexcept { mSpentNs += ns; }
+
+    void evict(void const* queue) { mDead.erase(queue); }
+    void clear();
+    void shrink() { mDead.shrinkToFit(); }
+
+    [[nodiscard]] size_t memoryUsage() const noexcept { return mDead.memoryUsage(); }
+
+    [[nodiscard]] size_t          pending() const noexcept { return mDead.size(); }
+    [[nodiscard]] Counters        takeCounters() noexcept;
+    [[nodiscard]] Counters const& counters() const noexcept { return mCounters; }
+
+private:
+    Settings                       mSettings;
+    uint64_t                       mSpentNs = 0;
+    FlatMap<void const*, uint32_t> mDead; // 队列 → 估计墓碑数
+    Counters                       mCounters;
+};
+
+} // namespace pending_tick_optimizer
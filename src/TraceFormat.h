@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+
+namespace pending_tick_optimizer::trace {
+
+// 计划刻 trace 的文件格式，录制端和离线回放共用
+// 文件 = FileHeader + 连续的 Record；TypeName 记录后紧跟 length 字节的类型名
+// 字段按小端原样写出，只在同一架构上读写
+
+inline constexpr char     kMagic[4] = {'P', 'T', 'O', 'T'};
+inline constexpr uint16_t kVersion  = 1;
+
+struct FileHeader {
+    char     magic[4];
+    uint16_t version;
+    uint16_t recordSize;
+    int64_t  startMs; // 开始录制时的 unix 毫秒
+};
+static_assert(sizeof(FileHeader) == 16);
+
+enum class RecordKind : uint8_t {
+    Call     = 0, // 一次 tickPendingTicks
+    Tick     = 1, // 一次 Level::tick 结束
+    TypeName = 2, // 类型编号到名称的映射，总在第一次用到该编号的 Call 之前
+};
+
+enum RecordFlags : uint8_t {
+    kFlagNear   = 1 << 0, // 近处区块
+    kFlagForced = 1 << 1, // 饥饿强制放行
+};
+
+struct Record {
+    RecordKind kind      = RecordKind::Call;
+    int8_t     dimension = 0;
+    int8_t     policy    = -1; // -1 为放行
+    uint8_t    flags     = 0;  // RecordFlags
+    uint32_t   tick      = 0;
+    uint32_t   queue     = 0; // Call：录制期间分配的队列编号；TypeName：类型编号
+    uint32_t   queueSize = 0; // Call：调用时的队列长度；Tick：本 tick 的全局预算；TypeName：名称字节数
+    int32_t    chunkX    = 0;
+    int32_t    chunkZ    = 0;
+    int32_t    max       = 0; // 调用方传入的 max
+    int32_t    want      = 0; // 单次上限和队列长度截断后的需求
+    int32_t    allowed   = 0;
+    int32_t    processed = 0;
+    uint32_t   elapsedNs = 0;          // Call：本次调用耗时；Tick：整个 Level::tick 耗时
+    uint32_t   headType  = UINT32_MAX; // 队首方块的类型编号
+};
+static_assert(sizeof(Record) == 48);
+
+inline constexpr uint32_t kNoType = UINT32_MAX;
+
+} // namespace pending_tick_optimizer::trace
@@ -0,0 +1,132 @@
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+
+namespace pending_tick_optimizer {
+
+// 没攒够半个缓冲时也按这个间隔写一次盘，关服时丢得少
+static constexpr auto kFlushInterval = std::chrono::milliseconds(100);
+
+bool TraceRecorder::start(Settings const& settings, int64_t startMs) {
+    if (running()) return true;
+    std::error_code ec;
+    std::filesystem::create_directories(settings.path.parent_path(), ec);
+#if defined(_WIN32)
+    mFile = _wfopen(settings.path.c_str(), L"wb");
+#else
+    mFile = std::fopen(settings.path.c_str(), "wb");
+#endif
+    if (!mFile) return false;
+
+    trace::FileHeader header{};
+    std::memcpy(header.magic, trace::kMagic, sizeof(header.magic));
+    header.version    = trace::kVersion;
+    header.recordSize = sizeof(trace::Record);
+    header.startMs    = startMs;
+    std::fwrite(&header, sizeof(header), 1, mFile);
+
+    mRing.assign(std::bit_ceil(std::max<size_t>(settings.capacity, 1024)), trace::Record{});
+    mMask = mRing.size() - 1;
+    mHead.store(0, std::memory_order_relaxed);
+    mTail.store(0, std::memory_order_relaxed);
+    mDropped.store(0, std::memory_order_relaxed);
+    mWritten.store(0, std::memory_order_relaxed);
+    mQueueIds.clear();
+    mNextQueue = 0;
+    mNamed.clear();
+    mNames.clear();
+    mStopping = false;
+    mThread   = std::thread([this] { run(); });
+    return true;
+}
+
+void TraceRecorder::stop() {
+    if (!running()) return;
+    {
+        std::lock_guard lock(mMutex);
+        mStopping = true;
+    }
+    mWake.notify_one();
+    mThread.join();
+    std::fclose(mFile);
+    mFile = nullptr;
+    // 缓冲不小，停止后还给系统
+    mRing = {};
+    mQueueIds.clear();
+}
+
+void TraceRecorder::record(trace::Record const& record) {
+    size_t head = mHead.load(std::memory_order_relaxed);
+    size_t used = head - mTail.load(std::memory_order_acquire);
+    if (used > mMask) {
+        mDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    mRing[head & mMask] = record;
+    mHead.store(head + 1, std::memory_order_release);
+    // 过半时提前叫醒写盘线程
+    if (used == mRing.size() / 2) mWake.notify_one();
+}
+
+void TraceRecorder::nameType(uint32_t type, std::string const& name) {
+    if (type == trace::kNoType) return;
+    if (type < mNamed.size() && mNamed[type]) return;
+    if (type >= mNamed.size()) mNamed.resize(type + 1, false);
+    mNamed[type] = true;
+    std::lock_guard lock(mMutex);
+    mNames.emplace_back(type, name);
+}
+
+uint32_t TraceRecorder::queueId(void const* queue) {
+    if (auto* id = mQueueIds.find(queue)) return *id;
+    uint32_t id      = mNextQueue++;
+    mQueueIds[queue] = id;
+    return id;
+}
+
+void TraceRecorder::run() {
+    std::unique_lock lock(mMutex);
+    while (!mStopping) {
+        mWake.wait_for(lock, kFlushInterval);
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+    lock.unlock();
+    flush();
+}
+
+void TraceRecorder::flush() {
+    // 先取记录的范围再取类型名：名称总在用到它的记录之前登记，这样范围内用到的名称一定已经在列表里
+    size_t tail = mTail.load(std::memory_order_relaxed);
+    size_t head = mHead.load(std::memory_order_acquire);
+
+    std::vector<std::pair<uint32_t, std::string>> names;
+    {
+        std::lock_guard lock(mMutex);
+        names.swap(mNames);
+    }
+    for (auto const& [type, name] : names) {
+        trace::Record record{};
+        record.kind      = trace::RecordKind::TypeName;
+        record.queue     = type;
+        record.queueSize = static_cast<uint32_t>(name.size());
+        std::fwrite(&record, sizeof(record), 1, mFile);
+        std::fwrite(name.data(), 1, name.size(), mFile);
+    }
+
+    // 环形缓冲最多分两段连续写出
+    while (tail != head) {
+        size_t begin = tail & mMask;
+        size_t count = std::min(head - tail, mRing.size() - begin);
+        std::fwrite(&mRing[begin], sizeof(trace::Record), count, mFile);
+        tail += count;
+        mTail.store(tail, std::memory_order_release);
+        mWritten.fetch_add(count, std::memory_order_relaxed);
+    }
+    std::fflush(mFile);
+}
+
+} // namespace pending_tick_optimizer
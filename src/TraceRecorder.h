@@ -0,0 +1,79 @@
+#pragma once
+#include "FlatMap.h"
+#include "TraceFormat.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace pending_tick_optimizer {
+
+// 把 tickPendingTicks 的调用录成二进制 trace，供离线回放
+// 记录写进预分配的单生产者环形缓冲，后台线程定期成批写盘；缓冲写满时丢弃新记录并计数
+// record* 只在服务器线程上调用
+class TraceRecorder {
+public:
+    struct Settings {
+        std::filesystem::path path;
+        size_t                capacity = 65536; // 环形缓冲的记录数，向上取整到 2 的幂
+    };
+
+    TraceRecorder() = default;
+    TraceRecorder(TraceRecorder const&)            = delete;
+    TraceRecorder& operator=(TraceRecorder const&) = delete;
+    ~TraceRecorder() { stop(); }
+
+    // 文件打不开时返回 false
+    bool start(Settings const& settings, int64_t startMs);
+    // 写完缓冲里剩下的记录后关闭文件
+    void stop();
+
+    [[nodiscard]] bool running() const noexcept { return mThread.joinable(); }
+
+    void record(trace::Record const& record);
+    // 类型编号第一次出现时登记名称
+    void nameType(uint32_t type, std::string const& name);
+
+    // 录制期间的队列编号，比指针紧凑，也不会因为地址复用把两个队列混在一起
+    uint32_t queueId(void const* queue);
+    void     evict(void const* queue) { mQueueIds.erase(queue); }
+    void     shrink() { mQueueIds.shrinkToFit(); }
+
+    [[nodiscard]] size_t memoryUsage() const noexcept {
+        return mRing.capacity() * sizeof(trace::Record) + mQueueIds.memoryUsage();
+    }
+
+    [[nodiscard]] uint64_t dropped() const noexcept { return mDropped.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t written() const noexcept { return mWritten.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+    void flush();
+
+    std::vector<trace::Record> mRing;
+    size_t                     mMask = 0;
+    std::atomic<size_t>        mHead{0}; // 只由生产者推进
+    std::atomic<size_t>        mTail{0}; // 只由写盘线程推进
+    std::atomic<uint64_t>      mDropped{0};
+    std::atomic<uint64_t>      mWritten{0};
+
+    std::FILE*                                    mFile = nullptr;
+    std::thread                                   mThread;
+    std::mutex                                    mMutex;
+    std::condition_variable                       mWake;
+    bool                                          mStopping = false;
+    std::vector<std::pair<uint32_t, std::string>> mNames; // 待写出的类型名，受 mMutex 保护
+
+    // 以下只在服务器线程上访问
+    FlatMap<void const*, uint32_t> mQueueIds;
+    uint32_t                       mNextQueue = 0;
+    std::vector<bool>              mNamed;
+};
+
+} // namespace pending_tick_optimizer
@@ -0,0 +1,143 @@
+#include "TypeColumns.h"
+#include <bit>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define PTO_X86 1
+#define PTO_TARGET_AVX2
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PTO_X86 1
+#define PTO_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace pending_tick_optimizer {
+
+// ── 成员计数 ──────────────────────────────────────────────
+
+static size_t countScalar(uint16_t const* ids, size_t n, uint16_t const* set, size_t setSize) noexcept {
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint16_t id = ids[i];
+        for (size_t k = 0; k < setSize; ++k) {
+            if (id == set[k]) {
+                ++count;
+                break;
+            }
+        }
+    }
+    return count;
+}
+
+#ifdef PTO_X86
+// set 里的 id 各不相同，每条 id 至多与一个相等，逐个比较后或起来即可
+static size_t countSse2(uint16_t const* ids, size_t n, uint16_t const* set, size_t setSize) noexcept {
+    size_t count = 0;
+    size_t i     = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v   = _mm_loadu_si128(reinterpret_cast<__m128i const*>(ids + i));
+        __m128i hit = _mm_setzero_si128();
+        for (size_t k = 0; k < setSize; ++k) {
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi16(v, _mm_set1_epi16(static_cast<short>(set[k]))));
+        }
+        // 每个 16 位通道在字节掩码里占两位
+        count += static_cast<size_t>(std::popcount(static_cast<uint32_t>(_mm_movemask_epi8(hit)))) / 2;
+    }
+    return count + countScalar(ids + i, n - i, set, setSize);
+}
+
+PTO_TARGET_AVX2 static size_t countAvx2(uint16_t const* ids, size_t n, uint16_t const* set, size_t setSize) noexcept {
+    size_t count = 0;
+    size_t i     = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i v   = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(ids + i));
+        __m256i hit = _mm256_setzero_si256();
+        for (size_t k = 0; k < setSize; ++k) {
+            hit = _mm256_or_si256(hit, _mm256_cmpeq_epi16(v, _mm256_set1_epi16(static_cast<short>(set[k]))));
+        }
+        count += static_cast<size_t>(std::popcount(static_cast<uint32_t>(_mm256_movemask_epi8(hit)))) / 2;
+    }
+    return count + countSse2(ids + i, n - i, set, setSize);
+}
+
+static bool cpuHasAvx2() noexcept {
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7) return false;
+    __cpuid(regs, 1);
+    bool osxsave = (regs[2] >> 27) & 1;
+    bool avx     = (regs[2] >> 28) & 1;
+    // 操作系统要保存 YMM 状态才能用 AVX
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+    __cpuidex(regs, 7, 0);
+    return (regs[1] >> 5) & 1;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+static SimdLevel detectSimdLevel() noexcept {
+#ifdef PTO_X86
+    return cpuHasAvx2() ? SimdLevel::Avx2 : SimdLevel::Sse2;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+SimdLevel simdLevel() noexcept {
+    static SimdLevel const level = detectSimdLevel();
+    return level;
+}
+
+char const* simdLevelName(SimdLevel level) noexcept {
+    switch (level) {
+    case SimdLevel::Avx2:
+        return "AVX2";
+    case SimdLevel::Sse2:
+        return "SSE2";
+    default:
+        return "scalar";
+    }
+}
+
+size_t countMembersWith(SimdLevel level, uint16_t const* ids, size_t n, uint16_t const* set, size_t setSize) noexcept {
+    if (setSize == 0) return 0;
+    if (level > simdLevel()) level = simdLevel();
+#ifdef PTO_X86
+    if (level == SimdLevel::Avx2) return countAvx2(ids, n, set, setSize);
+    if (level == SimdLevel::Sse2) return countSse2(ids, n, set, setSize);
+#endif
+    return countScalar(ids, n, set, setSize);
+}
+
+size_t countMembers(uint16_t const* ids, size_t n, uint16_t const* set, size_t setSize) noexcept {
+    return countMembersWith(simdLevel(), ids, n, set, setSize);
+}
+
+// ── 类型 id ───────────────────────────────────────────────
+
+uint16_t TypeIdTable::idFor(std::string_view name) {
+    if (auto it = mNames.find(std::string(name)); it != mNames.end()) return it->second;
+    if (mNames.size() + 1 >= kOverflow) return kOverflow;
+    auto id = static_cast<uint16_t>(mNames.size() + 1);
+    mNames.emplace(std::string(name), id);
+    return id;
+}
+
+size_t TypeIdTable::memoryUsage() const noexcept {
+    // unordered_map 的节点开销按键值大小加两个指针估计
+    size_t total = mBlocks.memoryUsage() + mNames.bucket_count() * sizeof(void*);
+    for (auto const& [name, id] : mNames) total += sizeof(name) + name.capacity() + sizeof(id) + 2 * sizeof(void*);
+    return total;
+}
+
+void TypeIdTable::clear() {
+    mNames.clear();
+    mBlocks.clear();
+    mLastBlock = nullptr;
+    mLastId    = kNone;
+}
+
+} // namespace pending_tick_optimizer
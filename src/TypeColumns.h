@@ -0,0 +1,102 @@
+#pragma once
+#include "FlatMap.h"
+#include "TickArena.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace pending_tick_optimizer {
+
+// 全量扫描用的紧凑列：先按步长读一遍 BlockTick，把方块收成 16 位类型 id 的连续数组，
+// 再对数组做向量化的集合成员计数（AVX2 / SSE2，启动时按 CPU 选择，非 x86 走标量）
+// 类型 id 按类型名分配，同一类型的不同方块状态共享一个 id；0 保留给墓碑和空方块，不属于任何集合
+
+enum class SimdLevel : uint8_t {
+    Scalar,
+    Sse2,
+    Avx2,
+};
+
+[[nodiscard]] SimdLevel   simdLevel() noexcept; // 首次调用时检测，之后固定
+[[nodiscard]] char const* simdLevelName(SimdLevel level) noexcept;
+
+// ids[0, n) 中落在 set[0, setSize) 里的个数
+[[nodiscard]] size_t countMembers(uint16_t const* ids, size_t n, uint16_t const* set, size_t setSize) noexcept;
+// 指定实现，压测和对拍用；请求的级别 CPU 不支持时降级
+[[nodiscard]] size_t
+countMembersWith(SimdLevel level, uint16_t const* ids, size_t n, uint16_t const* set, size_t setSize) noexcept;
+
+// 方块 → 类型 id，非线程安全
+class TypeIdTable {
+public:
+    static constexpr uint16_t kNone     = 0;      // 墓碑、空方块
+    static constexpr uint16_t kOverflow = 0xffff; // id 用完后的类型，不属于任何集合
+
+    // typeNameOf 只在缓存未命中时调用
+    template <class NameFn>
+    uint16_t idOf(void const* block, NameFn&& typeNameOf) {
+        if (!block) return kNone;
+        if (block == mLastBlock) return mLastId;
+        uint16_t id;
+        if (auto* cached = mBlocks.find(block)) {
+            id = *cached;
+        } else {
+            id             = idFor(typeNameOf());
+            mBlocks[block] = id;
+        }
+        mLastBlock = block;
+        mLastId    = id;
+        return id;
+    }
+
+    // 类型名 → id，未见过的类型分配新 id；配置里的方块列表用它转换成 id 集合
+    uint16_t idFor(std::string_view name);
+
+    void clear();
+
+    [[nodiscard]] size_t types() const noexcept { return mNames.size(); }
+    [[nodiscard]] size_t memoryUsage() const noexcept;
+
+private:
+    std::unordered_map<std::string, uint16_t> mNames;
+    FlatMap<void const*, uint16_t>            mBlocks;
+    void const*                               mLastBlock = nullptr;
+    uint16_t                                  mLastId    = kNone;
+};
+
+// 一次扫描的列，内存来自本 tick 的 arena
+struct TypeColumns {
+    uint16_t* ids  = nullptr;
+    size_t    size = 0;
+    size_t    live = 0;
+    size_t    dead = 0;
+
+    // ticks 为 BlockTick 序列；idOf(block) 返回类型 id
+    template <class Ticks, class IdOf>
+    static TypeColumns gather(Ticks const& ticks, TickArena& arena, IdOf&& idOf) {
+        TypeColumns columns;
+        columns.size  = ticks.size();
+        columns.ids   = arena.allocate<uint16_t>(columns.size);
+        uint16_t* out = columns.ids;
+        for (auto const& entry : ticks) {
+            uint16_t id = TypeIdTable::kNone;
+            if (entry.mIsRemoved) {
+                ++columns.dead;
+            } else if (entry.mData.mBlock) {
+                id = idOf(entry.mData.mBlock);
+                ++columns.live;
+            }
+            *out++ = id;
+        }
+        return columns;
+    }
+
+    [[nodiscard]] size_t count(std::vector<uint16_t> const& set) const noexcept {
+        return set.empty() ? 0 : countMembers(ids, size, set.data(), set.size());
+    }
+};
+
+} // namespace pending_tick_optimizer
@@ -0,0 +1,120 @@
+#include "WorldProfile.h"
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <type_traits>
+#include <utility>
+
+namespace pending_tick_optimizer {
+
+namespace {
+
+template <class T>
+T valueOr(nlohmann::json const& json, char const* key, T fallback) {
+    auto it = json.find(key);
+    if (it == json.end() || it->is_null()) return fallback;
+    if constexpr (std::is_same_v<T, std::string>) {
+        return it->is_string() ? it->get<std::string>() : fallback;
+    } else {
+        return it->is_number() ? it->get<T>() : fallback;
+    }
+}
+
+} // namespace
+
+bool WorldProfile::load(std::filesystem::path const& path) {
+    std::ifstream file(path);
+    if (!file) return false;
+    auto json = nlohmann::json::parse(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>(), nullptr, false);
+    if (json.is_discarded() || !json.is_object()) return false;
+    if (valueOr(json, "version", 0) != kVersion) return false;
+
+    WorldProfile profile;
+    profile.savedAt = valueOr<int64_t>(json, "savedAt", 0);
+    if (auto it = json.find("controller"); it != json.end() && it->is_object()) {
+        profile.controller.budget     = valueOr(*it, "budget", 0);
+        profile.controller.smoothMspt = valueOr(*it, "smoothMspt", 0.0);
+        profile.controller.lastMspt   = valueOr(*it, "lastMspt", 0.0);
+    }
+    if (auto it = json.find("policies"); it != json.end() && it->is_object()) {
+        for (auto policy = it->begin(); policy != it->end(); ++policy) {
+            if (!policy->is_number()) continue;
+            profile.policies.push_back({.name = policy.key(), .nsPerTick = policy->get<double>()});
+        }
+    }
+    if (auto it = json.find("costs"); it != json.end() && it->is_object()) {
+        for (auto type = it->begin(); type != it->end(); ++type) {
+            if (!type->is_object()) continue;
+            profile.costs.push_back({
+                .name    = type.key(),
+                .ns      = valueOr(*type, "ns", 0.0),
+                .samples = valueOr<uint64_t>(*type, "samples", 0),
+            });
+        }
+    }
+    if (auto it = json.find("hotspots"); it != json.end() && it->is_array()) {
+        for (auto const& spot : *it) {
+            if (!spot.is_object()) continue;
+            profile.hotSpots.push_back({
+                .key   = valueOr<uint64_t>(spot, "key", 0),
+                .cost  = valueOr(spot, "cost", 0.0),
+                .error = valueOr(spot, "error", 0.0),
+                .ticks = valueOr<uint64_t>(spot, "ticks", 0),
+                .calls = valueOr<uint64_t>(spot, "calls", 0),
+            });
+        }
+    }
+    *this = std::move(profile);
+    return true;
+}
+
+bool WorldProfile::save(std::filesystem::path const& path) const {
+    nlohmann::json policyCosts = nlohmann::json::object();
+    for (auto const& policy : policies) {
+        if (policy.nsPerTick > 0.0) policyCosts[policy.name] = policy.nsPerTick;
+    }
+    nlohmann::json typeCosts = nlohmann::json::object();
+    for (auto const& type : costs) {
+        if (type.samples == 0) continue;
+        typeCosts[type.name] = {
+            {"ns",      type.ns     },
+            {"samples", type.samples},
+        };
+    }
+    // 热点键原样保存（packChunkKey），只在同一个插件版本之间读写
+    nlohmann::json spots = nlohmann::json::array();
+    for (auto const& spot : hotSpots) {
+        spots.push_back({
+            {"key",   spot.key  },
+            {"cost",  spot.cost },
+            {"error", spot.error},
+            {"ticks", spot.ticks},
+            {"calls", spot.calls},
+        });
+    }
+    nlohmann::json out{
+        {"version",    kVersion},
+        {"savedAt",    savedAt },
+        {"controller",
+         {
+             {"budget", controller.budget},
+             {"smoothMspt", controller.smoothMspt},
+             {"lastMspt", controller.lastMspt},
+         }},
+        {"policies",   std::move(policyCosts)},
+        {"costs",      std::move(typeCosts)  },
+        {"hotspots",   std::move(spots)      },
+    };
+
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    // 先写临时文件再替换，避免关服时写到一半留下损坏的文件
+    auto          temp = std::filesystem::path(path).concat(".tmp");
+    std::ofstream file(temp);
+    file << out.dump(4);
+    file.close();
+    if (!file) return false;
+    std::filesystem::rename(temp, path, ec);
+    return !ec;
+}
+
+} // namespace pending_tick_optimizer
@@ -0,0 +1,33 @@
+#pragma once
+#include "AdaptiveController.h"
+#include "CostModel.h"
+#include "HotSpotTracker.h"
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace pending_tick_optimizer {
+
+// 每个世界的运行档案：disable 时保存自适应控制器的状态、学到的方块成本、各策略的单刻耗时和热点区块，
+// 下次 load 时读回，预算从接近稳态的值起步，不用每次重启都从 config.json 的静态值重新收敛
+struct WorldProfile {
+    static constexpr int kVersion = 1;
+
+    struct PolicyCost {
+        std::string name;
+        double      nsPerTick = 0.0;
+    };
+
+    int64_t                            savedAt = 0;  // unix 秒
+    AdaptiveController::State          controller;   // budget 为 0 表示保存时没有开自适应预算
+    std::vector<PolicyCost>            policies;     // 按名称对应，配置里改了顺序也能用
+    std::vector<CostModel::TypeCost>   costs;
+    std::vector<HotSpotTracker::Entry> hotSpots;
+
+    // 文件不存在、损坏或版本不符时返回 false，已有字段保持不变
+    bool load(std::filesystem::path const& path);
+    bool save(std::filesystem::path const& path) const;
+};
+
+} // namespace pending_tick_optimizer
@@ -0,0 +1,320 @@
+// pto-bench：插件热路径的微基准，基于 Google Benchmark
+// 用法：xmake f --microbench=y && xmake build pto-bench
+//       xmake run pto-bench --benchmark_out=bench.json --benchmark_out_format=json
+// 两次提交的 JSON 用 Google Benchmark 自带的 tools/compare.py 对比
+//
+// 输入是合成的队列，结构与 BlockTickingQueue 的 TickDataSet 相同（mData.mBlock / mData.mPos / mIsRemoved），
+// 按长度和方块构成（传送门占比）组合；方块是假的，类型名只在缓存未命中时读取，与游戏内一致
+#include "BlockClassifier.h"
+#include "LatencyHistogram.h"
+#include "ThreadSlots.h"
+#include "TickArena.h"
+#include "TypeColumns.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace pending_tick_optimizer;
+
+namespace {
+
+// ── 合成输入 ──────────────────────────────────────────────
+
+struct FakeBlock {
+    std::string name;
+
+    [[nodiscard]] std::string const& getTypeName() const { return name; }
+};
+
+struct FakePos {
+    int x = 0;
+    int y = 0;
+    int z = 0;
+};
+
+struct FakeTickData {
+    FakePos          mPos;
+    FakeBlock const* mBlock = nullptr;
+    uint64_t         mTick  = 0;
+};
+
+struct FakeTick {
+    FakeTickData mData;
+    bool         mIsRemoved = false;
+};
+
+// 每种类型若干个状态（不同的 Block 指针），与调色板里同一方块的多个状态对应
+constexpr int kStatesPerType = 4;
+
+std::vector<std::string> const kPortalTypes = {"minecraft:portal", "minecraft:end_portal", "minecraft:end_gateway"};
+std::vector<std::string> const kOtherTypes  = {
+    "minecraft:redstone_wire",
+    "minecraft:repeater",
+    "minecraft:observer",
+    "minecraft:water",
+    "minecraft:lava",
+    "minecraft:scaffolding",
+};
+
+// 地址要稳定，deque 扩容不会移动已有元素
+std::deque<FakeBlock> const& palette() {
+    static std::deque<FakeBlock> blocks = [] {
+        std::deque<FakeBlock> result;
+        for (auto const* types : {&kPortalTypes, &kOtherTypes}) {
+            for (auto const& name : *types) {
+                for (int i = 0; i < kStatesPerType; ++i) result.push_back({name});
+            }
+        }
+        return result;
+    }();
+    return blocks;
+}
+
+// portalPct% 的条目是传送门，deadPct% 是墓碑；固定种子，每次运行输入相同
+std::vector<FakeTick> makeQueue(size_t size, int portalPct, int deadPct = 0) {
+    auto const&                        blocks  = palette();
+    size_t                             portals = kPortalTypes.size() * kStatesPerType;
+    std::mt19937                       rng(static_cast<uint32_t>(size * 131 + portalPct * 7 + deadPct));
+    std::uniform_int_distribution<int> pct(0, 99);
+    std::vector<FakeTick>              queue(size);
+    for (size_t i = 0; i < size; ++i) {
+        bool   portal = pct(rng) < portalPct;
+        size_t index  = portal ? rng() % portals : portals + rng() % (blocks.size() - portals);
+        queue[i]      = {
+                 .mData     = {.mPos = {static_cast<int>(i % 16), 64, static_cast<int>(i / 16 % 16)}, .mBlock = &blocks[index]},
+                 .mIsRemoved = pct(rng) < deadPct,
+        };
+    }
+    return queue;
+}
+
+void queueArgs(benchmark::internal::Benchmark* bench) {
+    for (int size : {64, 1024, 16384}) {
+        for (int portalPct : {100, 90, 0}) bench->Args({size, portalPct});
+    }
+}
+
+std::vector<std::vector<std::string>> policyBlocks() { return {kPortalTypes, {"minecraft:redstone_wire"}}; }
+
+// ── 队列分类 ─────────────────────────────────────────────
+// 三种实现都回答同一个问题：队列里有多少条属于传送门策略
+
+// 最初的 isPortalOnlyQueue：逐条取类型名和方块列表比较
+void BM_ClassifyByName(benchmark::State& state) {
+    auto queue = makeQueue(static_cast<size_t>(state.range(0)), static_cast<int>(state.range(1)));
+    for (auto _ : state) {
+        size_t members = 0;
+        for (auto const& entry : queue) {
+            if (entry.mIsRemoved) continue;
+            auto const& name = entry.mData.mBlock->getTypeName();
+            if (std::find(kPortalTypes.begin(), kPortalTypes.end(), name) != kPortalTypes.end()) ++members;
+        }
+        benchmark::DoNotOptimize(members);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// 分类缓存：每条按 Block 指针查一次掩码
+void BM_ClassifyCached(benchmark::State& state) {
+    auto            queue = makeQueue(static_cast<size_t>(state.range(0)), static_cast<int>(state.range(1)));
+    BlockClassifier classifier;
+    classifier.setPolicies(policyBlocks());
+    for (auto _ : state) {
+        size_t members = 0;
+        for (auto const& entry : queue) {
+            if (entry.mIsRemoved) continue;
+            auto const* block = entry.mData.mBlock;
+            if (classifier.classify(block, [block]() -> std::string const& { return block->getTypeName(); }) & 1u) {
+                ++members;
+            }
+        }
+        benchmark::DoNotOptimize(members);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// 类型 id 列：先收集成 16 位 id，再按指定指令集计数
+template <SimdLevel Level>
+void BM_ClassifyColumns(benchmark::State& state) {
+    if (Level > simdLevel()) {
+        state.SkipWithError("instruction set not supported on this CPU");
+        return;
+    }
+    auto        queue = makeQueue(static_cast<size_t>(state.range(0)), static_cast<int>(state.range(1)));
+    TypeIdTable table;
+    TickArena   arena;
+    std::vector<uint16_t> set;
+    for (auto const& name : kPortalTypes) set.push_back(table.idFor(name));
+    auto idOf = [&table](FakeBlock const* block) {
+        return table.idOf(block, [block]() -> std::string const& { return block->getTypeName(); });
+    };
+    for (auto _ : state) {
+        arena.reset();
+        auto columns = TypeColumns::gather(queue, arena, idOf);
+        benchmark::DoNotOptimize(countMembersWith(Level, columns.ids, columns.size, set.data(), set.size()));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// 只测计数本身，列已经收集好
+template <SimdLevel Level>
+void BM_CountMembers(benchmark::State& state) {
+    if (Level > simdLevel()) {
+        state.SkipWithError("instruction set not supported on this CPU");
+        return;
+    }
+    auto                  queue = makeQueue(static_cast<size_t>(state.range(0)), static_cast<int>(state.range(1)));
+    TypeIdTable           table;
+    std::vector<uint16_t> set;
+    for (auto const& name : kPortalTypes) set.push_back(table.idFor(name));
+    std::vector<uint16_t> ids;
+    for (auto const& entry : queue) {
+        auto const* block = entry.mData.mBlock;
+        ids.push_back(table.idOf(block, [block]() -> std::string const& { return block->getTypeName(); }));
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(countMembersWith(Level, ids.data(), ids.size(), set.data(), set.size()));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_ClassifyByName)->Apply(queueArgs);
+BENCHMARK(BM_ClassifyCached)->Apply(queueArgs);
+BENCHMARK_TEMPLATE(BM_ClassifyColumns, SimdLevel::Scalar)->Apply(queueArgs);
+BENCHMARK_TEMPLATE(BM_ClassifyColumns, SimdLevel::Sse2)->Apply(queueArgs);
+BENCHMARK_TEMPLATE(BM_ClassifyColumns, SimdLevel::Avx2)->Apply(queueArgs);
+BENCHMARK_TEMPLATE(BM_CountMembers, SimdLevel::Scalar)->Apply(queueArgs);
+BENCHMARK_TEMPLATE(BM_CountMembers, SimdLevel::Sse2)->Apply(queueArgs);
+BENCHMARK_TEMPLATE(BM_CountMembers, SimdLevel::Avx2)->Apply(queueArgs);
+
+// ── 分类缓存 ──────────────────────────────────────────────
+
+// range(0) 个不同的 Block 轮流查询，上一次结果的快路径命不中，每次都要查表
+void BM_ClassifierLookup(benchmark::State& state) {
+    std::deque<FakeBlock> blocks;
+    for (int64_t i = 0; i < state.range(0); ++i) blocks.push_back({kOtherTypes[static_cast<size_t>(i) % kOtherTypes.size()]});
+    BlockClassifier classifier;
+    classifier.setPolicies(policyBlocks());
+    size_t i = 0;
+    for (auto _ : state) {
+        auto const* block = &blocks[i];
+        benchmark::DoNotOptimize(
+            classifier.classify(block, [block]() -> std::string const& { return block->getTypeName(); })
+        );
+        i = i + 1 == blocks.size() ? 0 : i + 1;
+    }
+    state.counters["cached"] = static_cast<double>(classifier.cachedCount());
+}
+
+// 每次都是新方块：解析类型名并插入缓存，clear 的代价摊进每轮
+void BM_ClassifierMiss(benchmark::State& state) {
+    std::deque<FakeBlock> blocks;
+    for (int64_t i = 0; i < state.range(0); ++i) blocks.push_back({kOtherTypes[static_cast<size_t>(i) % kOtherTypes.size()]});
+    BlockClassifier classifier;
+    classifier.setPolicies(policyBlocks());
+    for (auto _ : state) {
+        classifier.clear();
+        for (auto const& block : blocks) {
+            benchmark::DoNotOptimize(
+                classifier.classify(&block, [&block]() -> std::string const& { return block.getTypeName(); })
+            );
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_ClassifierLookup)->Arg(16)->Arg(256)->Arg(4096);
+BENCHMARK(BM_ClassifierMiss)->Arg(16)->Arg(256)->Arg(4096);
+
+// ── 预算申请 ──────────────────────────────────────────────
+// 多线程同时申请全局预算：共享原子量上的 CAS 循环，对比每线程租约（与 takeGlobalBudget 相同的两条路径）
+
+constexpr int kBudgetRefill = 1 << 24;
+constexpr int kLeaseSize    = 32;   // 与 Config::budgetLeaseSize 默认值一致
+constexpr int kWantPerCall  = 4;
+
+std::atomic<int> sharedBudget{kBudgetRefill};
+ThreadSlots      slots;
+
+// 预算用完时补满，补充的代价对两种实现相同
+void refillIfEmpty() {
+    if (sharedBudget.load(std::memory_order_relaxed) <= 0) sharedBudget.fetch_add(kBudgetRefill, std::memory_order_relaxed);
+}
+
+void BM_BudgetCas(benchmark::State& state) {
+    for (auto _ : state) {
+        int granted = takeBudget(sharedBudget, kWantPerCall);
+        if (granted < kWantPerCall) refillIfEmpty();
+        benchmark::DoNotOptimize(granted);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_BudgetLeased(benchmark::State& state) {
+    auto& slot = slots.local(true);
+    for (auto _ : state) {
+        int granted = takeLeased(slot, sharedBudget, kWantPerCall, kLeaseSize);
+        if (granted < kWantPerCall) refillIfEmpty();
+        benchmark::DoNotOptimize(granted);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["refills"] = benchmark::Counter(
+        static_cast<double>(slot.refills.exchange(0, std::memory_order_relaxed)),
+        benchmark::Counter::kAvgIterations
+    );
+}
+
+BENCHMARK(BM_BudgetCas)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_BudgetLeased)->ThreadRange(1, 8)->UseRealTime();
+
+// ── 计数器 ────────────────────────────────────────────────
+// 每次 tickPendingTicks 都要更新的策略计数：所有线程共用 0 号槽，对比每线程独占一个缓存行对齐的槽
+
+void BM_CounterShared(benchmark::State& state) {
+    auto& tally = slots.local(false).policies[0];
+    for (auto _ : state) {
+        tally.calls.fetch_add(1, std::memory_order_relaxed);
+        tally.processed.fetch_add(kWantPerCall, std::memory_order_relaxed);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_CounterPerThread(benchmark::State& state) {
+    auto& tally = slots.local(true).policies[0];
+    for (auto _ : state) {
+        tally.calls.fetch_add(1, std::memory_order_relaxed);
+        tally.processed.fetch_add(kWantPerCall, std::memory_order_relaxed);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_CounterShared)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_CounterPerThread)->ThreadRange(1, 8)->UseRealTime();
+
+// ── 直方图 ────────────────────────────────────────────────
+
+LatencyHistogram histogram;
+
+// 记录值按对数均匀分布，覆盖从几十到几百万个 TSC 计数
+void BM_HistogramRecord(benchmark::State& state) {
+    std::mt19937_64       rng(static_cast<uint64_t>(state.thread_index()) + 1);
+    std::vector<uint64_t> values(4096);
+    for (auto& value : values) value = uint64_t{16} << (rng() % 18) | (rng() & 15);
+    size_t i = 0;
+    for (auto _ : state) {
+        histogram.record(values[i]);
+        i = (i + 1) & (values.size() - 1);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_HistogramRecord)->ThreadRange(1, 8)->UseRealTime();
+
+} // namespace
+
+BENCHMARK_MAIN();
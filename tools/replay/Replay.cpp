@@ -0,0 +1,369 @@
+// pto-replay：把录制的计划刻 trace 喂给预算和调度逻辑，离线比较不同参数下的限流效果
+// 用法：pto-replay <trace.ptt> [选项]，选项见 printUsage
+//
+// 回放是近似的：trace 只记录了实际发生的调用，回放中少处理的刻按队列记成欠账，
+// 在同一队列的后续调用里补上；单刻耗时取自录制时同一次调用，没有处理记录时用同类型的平均值
+#include "AdaptiveController.h"
+#include "BudgetPools.h"
+#include "LatencyHistogram.h"
+#include "StarvationScheduler.h"
+#include "TickArena.h"
+#include "TraceFormat.h"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace pending_tick_optimizer;
+
+namespace {
+
+struct Options {
+    char const*                  path              = nullptr;
+    int                          perCall           = 0;  // 0 沿用录制时的单次需求
+    int                          global            = -1; // -1 沿用录制时每 tick 的全局预算，0 不限
+    int                          dimension         = 0;
+    int                          area              = 0;
+    int                          areaShift         = 2;
+    bool                         rollover          = false;
+    int                          starvationReserve = 0; // 百分比
+    int                          maxStarvation     = 0;
+    bool                         adaptive          = false;
+    AdaptiveController::Settings adaptiveSettings;
+};
+
+void printUsage() {
+    std::printf(
+        "usage: pto-replay <trace.ptt> [options]\n"
+        "  --per-call N            per-call budget, 0 keeps the recorded demand\n"
+        "  --global N              global budget per tick, 0 unlimited, default: as recorded\n"
+        "  --dimension N           per-dimension budget per tick\n"
+        "  --area N                per-area budget per tick\n"
+        "  --area-shift N          area size as 2^N chunks (default 2)\n"
+        "  --rollover              finished dimensions hand leftovers to later ones\n"
+        "  --starvation-reserve P  percent of the global budget reserved for starving queues\n"
+        "  --max-starvation N      force a starving queue through after N ticks\n"
+        "  --adaptive              drive the global budget with the AIMD controller\n"
+        "  --target-mspt X         adaptive target (default 45)\n"
+        "  --min-budget N / --max-budget N\n"
+    );
+}
+
+bool parseInt(char const* text, int& out) {
+    char* end = nullptr;
+    long  v   = std::strtol(text, &end, 10);
+    if (!end || *end != '\0') return false;
+    out = static_cast<int>(v);
+    return true;
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg       = argv[i];
+        auto             intArg    = [&](int& out) { return i + 1 < argc && parseInt(argv[++i], out); };
+        auto             doubleArg = [&](double& out) { return i + 1 < argc && (out = std::atof(argv[++i])) > 0; };
+        bool             ok        = true;
+        if (arg == "--per-call") ok = intArg(options.perCall);
+        else if (arg == "--global") ok = intArg(options.global);
+        else if (arg == "--dimension") ok = intArg(options.dimension);
+        else if (arg == "--area") ok = intArg(options.area);
+        else if (arg == "--area-shift") ok = intArg(options.areaShift);
+        else if (arg == "--rollover") options.rollover = true;
+        else if (arg == "--starvation-reserve") ok = intArg(options.starvationReserve);
+        else if (arg == "--max-starvation") ok = intArg(options.maxStarvation);
+        else if (arg == "--adaptive") options.adaptive = true;
+        else if (arg == "--target-mspt") ok = doubleArg(options.adaptiveSettings.targetMspt);
+        else if (arg == "--min-budget") ok = intArg(options.adaptiveSettings.minBudget);
+        else if (arg == "--max-budget") ok = intArg(options.adaptiveSettings.maxBudget);
+        else if (!arg.starts_with("--") && !options.path) options.path = argv[i];
+        else ok = false;
+        if (!ok) {
+            std::fprintf(stderr, "invalid argument: %s\n", argv[i]);
+            return false;
+        }
+    }
+    return options.path != nullptr;
+}
+
+struct TypeTotals {
+    std::string name;
+    double      ns    = 0.0;
+    uint64_t    ticks = 0;
+};
+
+// 录制与回放两侧各一份的汇总
+struct Totals {
+    LatencyHistogram tickNs;
+    double           pendingNs   = 0.0;
+    uint64_t         processed   = 0;
+    uint64_t         capped      = 0;
+    uint64_t         fullyCapped = 0;
+};
+
+class Replayer {
+public:
+    explicit Replayer(Options const& options) : mOptions(options) {
+        if (options.adaptive) mAdaptive.reset(std::max(1, options.global > 0 ? options.global : 500));
+    }
+
+    void onTypeName(uint32_t type, std::string name) { typeOf(type).name = std::move(name); }
+
+    // Tick 记录写在该 tick 的调用之后，queueSize 是它开始时定下的全局预算，所以调用要攒到 Tick 记录出现再回放
+    void onTick(trace::Record const& tick, std::vector<trace::Record> const& calls) {
+        mRecordedBudget = static_cast<int>(tick.queueSize);
+        beginTick();
+        for (auto const& call : calls) onCall(call);
+        endTick(tick);
+    }
+
+    // 录制被截断时最后一个 tick 没有 Tick 记录：沿用上一 tick 的预算回放，不计入 tick 数
+    void onTrailingCalls(std::vector<trace::Record> const& calls) {
+        if (calls.empty()) return;
+        beginTick();
+        for (auto const& call : calls) onCall(call);
+    }
+
+    void report(uint64_t records) {
+        auto rec = mRecorded.tickNs.takeSummary(1e-6);
+        auto sim = mSimulated.tickNs.takeSummary(1e-6);
+        auto per = [this](double ns) { return mTicks > 0 ? ns / 1e6 / static_cast<double>(mTicks) : 0.0; };
+        std::printf(
+            "trace: %s | records: %llu | ticks: %llu | calls: %llu (throttled %llu)\n\n",
+            mOptions.path,
+            static_cast<unsigned long long>(records),
+            static_cast<unsigned long long>(mTicks),
+            static_cast<unsigned long long>(mCalls),
+            static_cast<unsigned long long>(mThrottledCalls)
+        );
+        std::printf("%-22s %14s %14s\n", "", "recorded", "simulated");
+        std::printf("%-22s %14.2f %14.2f\n", "mspt mean", rec.mean, sim.mean);
+        std::printf("%-22s %14.2f %14.2f\n", "mspt p50", rec.p50, sim.p50);
+        std::printf("%-22s %14.2f %14.2f\n", "mspt p99", rec.p99, sim.p99);
+        std::printf("%-22s %14.2f %14.2f\n", "mspt max", rec.max, sim.max);
+        std::printf("%-22s %14.3f %14.3f\n", "pending ms / tick", per(mRecorded.pendingNs), per(mSimulated.pendingNs));
+        auto row = [](char const* label, uint64_t a, uint64_t b) {
+            std::printf("%-22s %14llu %14llu\n", label, static_cast<unsigned long long>(a), static_cast<unsigned long long>(b));
+        };
+        row("processed", mRecorded.processed, mSimulated.processed);
+        row("capped calls", mRecorded.capped, mSimulated.capped);
+        row("fully capped calls", mRecorded.fullyCapped, mSimulated.fullyCapped);
+        auto starving = mStarvation.takeCounters();
+        std::printf("%-22s %14s %14llu\n", "starvation forced", "-", static_cast<unsigned long long>(starving.forced));
+        std::printf("%-22s %14s %14u\n", "starvation max age", "-", starving.maxAge);
+        std::printf("%-22s %14s %14lld\n", "peak extra backlog", "-", static_cast<long long>(mPeakBacklog));
+        if (mOptions.adaptive) {
+            std::printf("%-22s %14s %14d\n", "final adaptive budget", "-", mAdaptive.budget());
+        }
+
+        // 录制里最耗时的方块类型，即这份负载的构成
+        std::vector<TypeTotals const*> types;
+        for (auto const& type : mTypes) {
+            if (type.ticks > 0) types.push_back(&type);
+        }
+        std::sort(types.begin(), types.end(), [](auto const* a, auto const* b) { return a->ns > b->ns; });
+        if (!types.empty()) std::printf("\ntop block types by recorded time:\n");
+        for (size_t i = 0; i < std::min<size_t>(types.size(), 8); ++i) {
+            auto const& type = *types[i];
+            std::printf(
+                "  %-40s %10.2f ms %10llu ticks %8.2f us/tick\n",
+                type.name.empty() ? "(unnamed)" : type.name.c_str(),
+                type.ns / 1e6,
+                static_cast<unsigned long long>(type.ticks),
+                type.ns / 1000.0 / static_cast<double>(type.ticks)
+            );
+        }
+    }
+
+private:
+    void onCall(trace::Record const& record) {
+        ++mCalls;
+        mRecordedPendingNs += record.elapsedNs;
+        if (record.processed > 0 && record.headType != trace::kNoType) {
+            auto& type  = typeOf(record.headType);
+            type.ns    += record.elapsedNs;
+            type.ticks += static_cast<uint64_t>(record.processed);
+        }
+        mRecorded.processed += static_cast<uint64_t>(std::max(0, record.processed));
+
+        // 放行的队列两边一样
+        if (record.policy < 0) {
+            mSimPendingNs        += record.elapsedNs;
+            mSimulated.processed += static_cast<uint64_t>(std::max(0, record.processed));
+            return;
+        }
+        ++mThrottledCalls;
+        if (record.allowed < record.want) ++mRecorded.capped;
+        if (record.allowed <= 0) ++mRecorded.fullyCapped;
+
+        // 录制时本次可出队的量：没用完额度说明到期的就这么多，否则按需求估计
+        int   eligibleRec = record.processed < record.allowed ? record.processed : record.want;
+        auto& debt        = mDebt[record.queue];
+        int   eligible    = static_cast<int>(std::max<int64_t>(0, eligibleRec + debt));
+        int   want        = mOptions.perCall > 0 ? std::min({record.max, mOptions.perCall, eligible}) : eligible;
+
+        void const* key   = queueKey(record.queue);
+        auto        claim = mStarvation.claim(key, want);
+        int         taken = 0;
+        mGlobalLeft += claim.released;
+        if (claim.granted < want) {
+            int pooled = mPools.acquire(record.dimension, record.chunkX, record.chunkZ, want - claim.granted);
+            taken       = std::min(pooled, mGlobalLeft);
+            mGlobalLeft -= taken;
+            mPools.release(record.dimension, record.chunkX, record.chunkZ, pooled - taken);
+        }
+        int allowed = claim.granted + taken;
+        if (allowed < want) {
+            mStarvation.onCapped(key, want);
+            ++mSimulated.capped;
+            if (allowed <= 0) ++mSimulated.fullyCapped;
+        } else {
+            mStarvation.onServed(key);
+        }
+
+        int processed = std::min(allowed, eligible);
+        int fromClaim = std::min(processed, claim.granted);
+        int unused    = taken - (processed - fromClaim);
+        mPools.release(record.dimension, record.chunkX, record.chunkZ, unused);
+        mGlobalLeft += unused;
+        if (!claim.forced && claim.granted > fromClaim) mGlobalLeft += claim.granted - fromClaim;
+
+        mSimPendingNs        += nsPerTick(record) * processed;
+        mSimulated.processed += static_cast<uint64_t>(processed);
+        debt = (eligible - processed) - (eligibleRec - std::max(0, record.processed));
+    }
+
+    void endTick(trace::Record const& record) {
+        double recordedNs = record.elapsedNs;
+        double simNs      = std::max(0.0, recordedNs - mRecordedPendingNs + mSimPendingNs);
+        mRecorded.tickNs.record(static_cast<uint64_t>(recordedNs));
+        mSimulated.tickNs.record(static_cast<uint64_t>(simNs));
+        mRecorded.pendingNs  += mRecordedPendingNs;
+        mSimulated.pendingNs += mSimPendingNs;
+        if (mOptions.adaptive) mAdaptive.update(simNs / 1e6, mOptions.adaptiveSettings);
+
+        int64_t backlog = 0;
+        for (auto const& [queue, debt] : mDebt) backlog += std::max<int64_t>(0, debt);
+        mPeakBacklog = std::max(mPeakBacklog, backlog);
+        ++mTicks;
+        // 插件在统计任务里做的区域表清扫，回放按同样的频率做
+        if (mTicks % 100 == 0) mPools.sweep();
+    }
+
+    static void const* queueKey(uint32_t queue) {
+        // 0 是 FlatMap 的空槽标记
+        return reinterpret_cast<void const*>(static_cast<uintptr_t>(queue) + 1);
+    }
+
+    TypeTotals& typeOf(uint32_t type) {
+        if (type >= mTypes.size()) mTypes.resize(type + 1);
+        return mTypes[type];
+    }
+
+    double nsPerTick(trace::Record const& record) {
+        if (record.processed > 0) return static_cast<double>(record.elapsedNs) / record.processed;
+        if (record.headType < mTypes.size() && mTypes[record.headType].ticks > 0) {
+            auto const& type = mTypes[record.headType];
+            return type.ns / static_cast<double>(type.ticks);
+        }
+        return 0.0;
+    }
+
+    void beginTick() {
+        mRecordedPendingNs = 0.0;
+        mSimPendingNs      = 0.0;
+        mArena.reset();
+
+        int global = mOptions.adaptive ? mAdaptive.budget() : mOptions.global >= 0 ? mOptions.global : mRecordedBudget;
+        if (global <= 0) global = INT_MAX / 2;
+        auto reserve  = static_cast<int64_t>(global) * std::clamp(mOptions.starvationReserve, 0, 100) / 100;
+        int  reserved = mStarvation.beginTick(
+            {
+                .reserveBudget      = static_cast<int>(reserve),
+                .maxStarvationTicks = mOptions.maxStarvation,
+            },
+            mArena
+        );
+        mGlobalLeft = global - reserved;
+        mPools.beginTick({
+            .dimension = mOptions.dimension,
+            .area      = mOptions.area,
+            .areaShift = std::clamp(mOptions.areaShift, 0, 8),
+            .rollover  = mOptions.rollover,
+        });
+    }
+
+    Options const&                        mOptions;
+    BudgetPools                           mPools;
+    StarvationScheduler                   mStarvation;
+    TickArena                             mArena;
+    AdaptiveController                    mAdaptive;
+    std::vector<TypeTotals>               mTypes;
+    std::unordered_map<uint32_t, int64_t> mDebt; // 回放比录制多积压的刻数，负数表示回放处理得更多
+
+    int      mGlobalLeft        = 0;
+    int      mRecordedBudget    = 0;
+    double   mRecordedPendingNs = 0.0;
+    double   mSimPendingNs      = 0.0;
+    uint64_t mTicks             = 0;
+    uint64_t mCalls             = 0;
+    uint64_t mThrottledCalls    = 0;
+    int64_t  mPeakBacklog       = 0;
+    Totals   mRecorded;
+    Totals   mSimulated;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 2;
+    }
+
+    std::FILE* file = std::fopen(options.path, "rb");
+    if (!file) {
+        std::fprintf(stderr, "cannot open %s\n", options.path);
+        return 1;
+    }
+    trace::FileHeader header{};
+    if (std::fread(&header, sizeof(header), 1, file) != 1 || std::memcmp(header.magic, trace::kMagic, 4) != 0
+        || header.version != trace::kVersion || header.recordSize != sizeof(trace::Record)) {
+        std::fprintf(stderr, "%s is not a version %u trace\n", options.path, trace::kVersion);
+        std::fclose(file);
+        return 1;
+    }
+
+    Replayer                   replayer(options);
+    trace::Record              record;
+    std::vector<trace::Record> calls; // 当前 tick 还没等到 Tick 记录的调用
+    uint64_t                   records = 0;
+    while (std::fread(&record, sizeof(record), 1, file) == 1) {
+        ++records;
+        switch (record.kind) {
+        case trace::RecordKind::Call:
+            calls.push_back(record);
+            break;
+        case trace::RecordKind::Tick:
+            replayer.onTick(record, calls);
+            calls.clear();
+            break;
+        case trace::RecordKind::TypeName: {
+            std::string name(record.queueSize, '\0');
+            if (std::fread(name.data(), 1, name.size(), file) != name.size()) break;
+            replayer.onTypeName(record.queue, std::move(name));
+            break;
+        }
+        }
+    }
+    std::fclose(file);
+    replayer.onTrailingCalls(calls);
+    replayer.report(records);
+    return 0;
+}
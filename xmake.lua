@@ -16,6 +16,10 @@ else
 end
 
 add_defines("NOMINMAX", "UNICODE")
+-- 调试构建统计热路径的堆分配次数，见 src/AllocTracking.h
+if is_mode("debug") then
+    add_defines("PTO_ALLOC_TRACKING")
+end
 set_languages("c++20")
 set_optimize("fast")
 set_symbols("none")
@@ -33,3 +37,33 @@ target("PendingTickOptimizer")
     add_syslinks("shlwapi", "advapi32")
     set_targetdir("bin")
     set_runtimes("MD")
+
+-- 离线回放录制的 trace，只链接不依赖 LeviLamina 的预算与调度模块：xmake build pto-replay
+target("pto-replay")
+    set_kind("binary")
+    set_default(false)
+    set_languages("c++20")
+    add_files("tools/replay/*.cpp")
+    add_files("src/AdaptiveController.cpp", "src/BudgetPools.cpp", "src/LatencyHistogram.cpp", "src/StarvationScheduler.cpp", "src/TickArena.cpp")
+    set_targetdir("bin")
+
+-- 热路径微基准，依赖 Google Benchmark，默认不拉取：xmake f --microbench=y && xmake build pto-bench
+-- 结果输出为 JSON：xmake run pto-bench --benchmark_out=bench.json --benchmark_out_format=json
+option("microbench")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Build the pto-bench micro-benchmarks (requires Google Benchmark)")
+option_end()
+
+if has_config("microbench") then
+    add_requires("benchmark")
+
+    target("pto-bench")
+        set_kind("binary")
+        set_default(false)
+        set_languages("c++20")
+        add_files("tools/bench/*.cpp")
+        add_files("src/BlockClassifier.cpp", "src/LatencyHistogram.cpp", "src/ThreadSlots.cpp", "src/TickArena.cpp", "src/TypeColumns.cpp")
+        add_packages("benchmark")
+        set_targetdir("bin")
+end